@@ -0,0 +1,61 @@
+#include "bench.h"
+#include "corpus.h"
+#include "src/alloc.h"
+#include "src/eval.h"
+#include "src/json.h"
+#include "src/json_serde.h"
+#include "src/parser.h"
+#include <assert.h>
+#include <stdlib.h>
+
+typedef struct {
+    const char *name;
+    CorpusKind corpus;
+    char *query;
+} Query;
+
+/// Queries that create a lot of short lived lists, objects and strings.
+static const Query QUERIES[] = {
+    {"map_split", CORPUS_LOGS, ".map(|v| v.message.split(\" \").collect())"},
+    {"map_pairs", CORPUS_LOGS, ".map(|v| [v.level, v.host]).collect()"},
+    {"map_object", CORPUS_WIDE, ".map(|v| {\"a\": v.field_0, \"b\": v.field_1})"},
+    {"map_nested", CORPUS_NUMERIC, ".map(|v| v.map(|n| [n]).collect())"},
+};
+
+static void run(char *query, Json input) {
+    ParseResult parsed = ast_parse(query);
+    assert(parsed.type == RES_OK);
+    EvalResult res = eval(parsed.node, input);
+    assert(res.type == RES_OK);
+    json_free(res.json);
+}
+
+int main(void) {
+    for (size_t i = 0; i < sizeof(QUERIES) / sizeof(*QUERIES); i++) {
+        Query q = QUERIES[i];
+        Corpus corpus = corpus_generate(q.corpus, bench_corpus_bytes());
+        DeserializeResult input = json_deserialize(corpus.data);
+        assert(input.type == RES_OK);
+
+        char name[128];
+        snprintf(name, sizeof(name), "alloc_%s_%s", q.name, corpus_name(q.corpus));
+
+        // Once to warm up whatever is reused between runs, then once to count the allocations
+        run(q.query, input.result);
+        size_t allocations = jrq_allocations;
+        run(q.query, input.result);
+        allocations = jrq_allocations - allocations;
+
+        double ns;
+        bench_run(ns, run(q.query, input.result));
+        bench_report(name, corpus.length, corpus.elements, ns);
+        printf(
+            "{\"name\": \"%s\", \"allocations\": %zu, \"allocations_per_element\": %.2f}\n", name,
+            allocations, (double)allocations / (double)corpus.elements
+        );
+
+        json_free(input.result);
+        jrq_free(corpus.data);
+    }
+    return 0;
+}
@@ -0,0 +1,68 @@
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <time.h>
+
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+/// How long each benchmark runs for at least, `JRQ_BENCH_MS` milliseconds if it is set.
+static inline uint64_t bench_min_ns(void) {
+    char *ms = getenv("JRQ_BENCH_MS");
+    return (ms != NULL ? strtoull(ms, NULL, 10) : 300) * 1000000;
+}
+
+/// How big generated corpora are, `JRQ_BENCH_BYTES` if it is set.
+static inline size_t bench_corpus_bytes(void) {
+    char *bytes = getenv("JRQ_BENCH_BYTES");
+    return bytes != NULL ? strtoull(bytes, NULL, 10) : 4 * 1024 * 1024;
+}
+
+/// Runs `body` until at least `bench_min_ns()` have passed and sets `ns_per_iter` to the average
+/// time one run took.
+#define bench_run(ns_per_iter, body...)                                                            \
+    do {                                                                                           \
+        uint64_t __min = bench_min_ns();                                                           \
+        uint64_t __start = bench_now_ns();                                                         \
+        uint64_t __iters = 0;                                                                      \
+        do {                                                                                       \
+            body;                                                                                  \
+            __iters++;                                                                             \
+        } while (bench_now_ns() - __start < __min);                                                \
+        ns_per_iter = (double)(bench_now_ns() - __start) / (double)__iters;                        \
+    } while (0)
+
+/// The most memory this process has had resident so far, in KiB.
+static inline long bench_peak_rss_kb(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/// Prints one result as a line of json so that results can be compared by other tools.
+///
+/// `bytes` is the amount of input (or output) one run processes and `elements` the amount of
+/// records in it, either can be 0 if it doesn't apply.
+static inline void bench_report(const char *name, size_t bytes, size_t elements, double ns) {
+    printf(
+        "{\"name\": \"%s\", \"ns\": %.0f, \"bytes\": %zu, \"elements\": %zu", name, ns, bytes,
+        elements
+    );
+    if (bytes != 0) {
+        printf(", \"mb_per_s\": %.2f", (double)bytes / ns * 1e9 / (1024 * 1024));
+    }
+    if (elements != 0) {
+        printf(", \"ns_per_element\": %.2f", ns / (double)elements);
+    }
+    printf(", \"peak_rss_kb\": %ld}\n", bench_peak_rss_kb());
+    fflush(stdout);
+}
+
+#endif // _BENCH_H
@@ -0,0 +1,157 @@
+#include "corpus.h"
+#include "src/strings.h"
+#include <stdint.h>
+#include <string.h>
+
+#define DEEP_DEPTH 64
+#define WIDE_FIELDS 40
+
+static const char *NAMES[CORPUS_KIND_COUNT] = {
+    [CORPUS_WIDE] = "wide",
+    [CORPUS_DEEP] = "deep",
+    [CORPUS_NUMERIC] = "numeric",
+    [CORPUS_LOGS] = "logs",
+    [CORPUS_NDJSON] = "ndjson",
+};
+
+static const char *WORDS[] = {
+    "request", "handled", "in", "ms", "user", "connection", "reset", "by", "peer", "retrying",
+    // Words that need escaping or aren't ascii, they're only used every so often
+    "caf\xc3\xa9", "na\xc3\xafve", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "\\\"quoted\\\"",
+    "path\\\\to\\\\file", "line\\nbreak", "tab\\tstop",
+};
+#define PLAIN_WORDS 10
+#define WORD_COUNT (sizeof(WORDS) / sizeof(*WORDS))
+
+/// A xorshift generator, so that every corpus is the same every time on every platform.
+typedef struct {
+    uint32_t state;
+} Random;
+
+static uint32_t random_next(Random *r) {
+    r->state ^= r->state << 13;
+    r->state ^= r->state >> 17;
+    r->state ^= r->state << 5;
+    return r->state;
+}
+
+static void wide_record(String *s, Random *r, size_t i) {
+    string_append(s, string_from_chars("{"));
+    for (int f = 0; f < WIDE_FIELDS; f++) {
+        string_printf(s, "%s\"field_%d\": ", f == 0 ? "" : ", ", f);
+        switch (f % 5) {
+        case 0:
+            string_printf(s, "%u", random_next(r) % 100000);
+            break;
+        case 1:
+            string_printf(s, "\"value %u\"", random_next(r) % 1000);
+            break;
+        case 2:
+            string_append(s, string_from_chars(random_next(r) % 2 ? "true" : "null"));
+            break;
+        case 3:
+            string_printf(s, "[%zu, %d.5]", i, f);
+            break;
+        case 4:
+            string_printf(s, "{\"id\": %zu, \"tag\": \"t%d\"}", i, f);
+            break;
+        }
+    }
+    string_append(s, string_from_chars("}"));
+}
+
+static void deep_record(String *s, Random *r, size_t i) {
+    for (int d = 0; d < DEEP_DEPTH; d++) {
+        string_append(s, string_from_chars(d % 2 ? "[1, " : "{\"a\": "));
+    }
+    string_printf(s, "%zu", i);
+    for (int d = DEEP_DEPTH; d-- > 0;) {
+        string_append(s, string_from_chars(d % 2 ? "]" : "}"));
+    }
+}
+
+static void numeric_record(String *s, Random *r, size_t i) {
+    string_append(s, string_from_chars("["));
+    for (int n = 0; n < 16; n++) {
+        uint32_t v = random_next(r);
+        if (v % 3 == 0) {
+            string_printf(s, "%s%d", n == 0 ? "" : ", ", (int)(v % 2000000) - 1000000);
+        } else {
+            string_printf(s, "%s%u.%03u", n == 0 ? "" : ", ", v % 10000, (v >> 16) % 1000);
+        }
+    }
+    string_append(s, string_from_chars("]"));
+}
+
+static void logs_record(String *s, Random *r, size_t i) {
+    string_printf(s, "{\"level\": \"%s\", \"message\": \"", i % 7 ? "info" : "error");
+
+    int words = 8 + random_next(r) % 24;
+    for (int w = 0; w < words; w++) {
+        uint32_t v = random_next(r);
+        uint32_t word = v % WORD_COUNT;
+        if (word >= PLAIN_WORDS && (v >> 16) % 4 != 0) {
+            word %= PLAIN_WORDS;
+        }
+        string_printf(s, "%s%s", w == 0 ? "" : " ", WORDS[word]);
+    }
+    string_printf(
+        s, "\", \"host\": \"web-%zu.example.com\", \"status\": %u}", i % 16,
+        200 + random_next(r) % 4 * 100
+    );
+}
+
+static void ndjson_record(String *s, Random *r, size_t i) {
+    string_printf(
+        s, "{\"id\": %zu, \"user\": \"user%u\", \"score\": %u.%u, \"active\": %s}", i,
+        random_next(r) % 5000, random_next(r) % 100, random_next(r) % 10,
+        random_next(r) % 2 ? "true" : "false"
+    );
+}
+
+static void (*const RECORDS[CORPUS_KIND_COUNT])(String *, Random *, size_t) = {
+    [CORPUS_WIDE] = wide_record,
+    [CORPUS_DEEP] = deep_record,
+    [CORPUS_NUMERIC] = numeric_record,
+    [CORPUS_LOGS] = logs_record,
+    [CORPUS_NDJSON] = ndjson_record,
+};
+
+/// Generates records of `kind` until the corpus is at least `bytes` long. The same corpus is
+/// generated for the same arguments every time.
+Corpus corpus_generate(CorpusKind kind, size_t bytes) {
+    String s = string_from_chars_alloc("");
+    Random r = {.state = 0x9E3779B9 ^ (uint32_t)kind};
+    bool ndjson = kind == CORPUS_NDJSON;
+
+    if (!ndjson) {
+        string_append(&s, string_from_chars("["));
+    }
+
+    size_t elements = 0;
+    do {
+        if (elements != 0) {
+            string_append(&s, string_from_chars(ndjson ? "\n" : ", "));
+        }
+        RECORDS[kind](&s, &r, elements);
+        elements++;
+    } while (s.length < bytes);
+
+    string_append(&s, string_from_chars(ndjson ? "\n" : "]"));
+
+    return (Corpus) {.data = s.data, .length = s.length, .elements = elements};
+}
+
+const char *corpus_name(CorpusKind kind) {
+    return NAMES[kind];
+}
+
+/// The kind of corpus called `name`, or -1 if there is none.
+int corpus_from_name(const char *name) {
+    for (int kind = 0; kind < CORPUS_KIND_COUNT; kind++) {
+        if (strcmp(NAMES[kind], name) == 0) {
+            return kind;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,34 @@
+#ifndef _CORPUS_H
+#define _CORPUS_H
+
+#include <stddef.h>
+
+typedef enum {
+    /// A list of flat objects with many fields of every type
+    CORPUS_WIDE,
+    /// A list of objects and lists that are nested very deep
+    CORPUS_DEEP,
+    /// A list of lists of numbers
+    CORPUS_NUMERIC,
+    /// A list of log records that are mostly strings, some of which need escaping
+    CORPUS_LOGS,
+    /// Small records separated by newlines instead of being in a list
+    CORPUS_NDJSON,
+
+    CORPUS_KIND_COUNT,
+} CorpusKind;
+
+typedef struct {
+    char *data;
+    size_t length;
+
+    /// The amount of records in the corpus, the elements of the top level list (or the lines of
+    /// ndjson)
+    size_t elements;
+} Corpus;
+
+Corpus corpus_generate(CorpusKind kind, size_t bytes);
+const char *corpus_name(CorpusKind kind);
+int corpus_from_name(const char *name);
+
+#endif // _CORPUS_H
@@ -0,0 +1,75 @@
+#include "bench.h"
+#include "corpus.h"
+#include "src/json.h"
+#include "src/json_serde.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void bench_whole(Corpus corpus, const char *kind) {
+    char name[128];
+    double ns;
+
+    snprintf(name, sizeof(name), "deserialize_%s", kind);
+    bench_run(ns, {
+        DeserializeResult res = json_deserialize(corpus.data);
+        assert(res.type == RES_OK);
+        json_free(res.result);
+    });
+    bench_report(name, corpus.length, corpus.elements, ns);
+
+    snprintf(name, sizeof(name), "deserialize_parallel_%s", kind);
+    bench_run(ns, {
+        DeserializeResult res = json_deserialize_parallel(corpus.data, 0);
+        assert(res.type == RES_OK);
+        json_free(res.result);
+    });
+    bench_report(name, corpus.length, corpus.elements, ns);
+
+    snprintf(name, sizeof(name), "deserialize_lazy_%s", kind);
+    bench_run(ns, {
+        DeserializeResult res = json_deserialize_lazy(corpus.data);
+        assert(res.type == RES_OK);
+        json_free(res.result);
+    });
+    bench_report(name, corpus.length, corpus.elements, ns);
+}
+
+/// Every line is deserialized on its own, which is how ndjson has to be read.
+static void bench_lines(Corpus corpus, const char *kind) {
+    char **lines = malloc(corpus.elements * sizeof(*lines));
+    size_t count = 0;
+    for (char *line = corpus.data; *line != '\0';) {
+        char *end = strchr(line, '\n');
+        *end = '\0';
+        lines[count++] = line;
+        line = end + 1;
+    }
+
+    char name[128];
+    snprintf(name, sizeof(name), "deserialize_%s", kind);
+
+    double ns;
+    bench_run(ns, {
+        for (size_t i = 0; i < count; i++) {
+            DeserializeResult res = json_deserialize(lines[i]);
+            assert(res.type == RES_OK);
+            json_free(res.result);
+        }
+    });
+    bench_report(name, corpus.length, count, ns);
+    jrq_free(lines);
+}
+
+int main(void) {
+    for (CorpusKind kind = 0; kind < CORPUS_KIND_COUNT; kind++) {
+        Corpus corpus = corpus_generate(kind, bench_corpus_bytes());
+        if (kind == CORPUS_NDJSON) {
+            bench_lines(corpus, corpus_name(kind));
+        } else {
+            bench_whole(corpus, corpus_name(kind));
+        }
+        jrq_free(corpus.data);
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+#include "bench.h"
+#include "corpus.h"
+#include "src/eval.h"
+#include "src/json.h"
+#include "src/json_serde.h"
+#include "src/parser.h"
+#include <assert.h>
+#include <stdlib.h>
+
+typedef struct {
+    const char *name;
+    CorpusKind corpus;
+    char *query;
+} Query;
+
+static const Query QUERIES[] = {
+    {"access", CORPUS_WIDE, ".map(|v| v.field_3)"},
+    {"filter", CORPUS_WIDE, ".filter(|v| v.field_7 == true).map(|v| v.field_0)"},
+    {"arithmetic", CORPUS_NUMERIC, ".map(|v| v[0] * 2 + v[1])"},
+    {"nested_filter", CORPUS_NUMERIC, ".map(|v| v.filter(|n| n > 0).collect())"},
+    {"enumerate", CORPUS_WIDE, ".enumerate().filter(|[i, v]| i > 10).map(|[i, v]| v.field_4.id)"},
+    {"keys", CORPUS_WIDE, ".map(|v| v.keys().collect())"},
+    {"split", CORPUS_LOGS, ".map(|v| v.message.split(\" \").length())"},
+    {"take", CORPUS_LOGS, ".skip_while(|v| v.level == \"info\").take(100).collect()"},
+};
+
+int main(void) {
+    for (size_t i = 0; i < sizeof(QUERIES) / sizeof(*QUERIES); i++) {
+        Query q = QUERIES[i];
+        Corpus corpus = corpus_generate(q.corpus, bench_corpus_bytes());
+        DeserializeResult input = json_deserialize(corpus.data);
+        assert(input.type == RES_OK);
+
+        char name[128];
+        snprintf(name, sizeof(name), "eval_%s_%s", q.name, corpus_name(q.corpus));
+
+        // The query is parsed every time as well, `eval` consumes it
+        double ns;
+        bench_run(ns, {
+            ParseResult parsed = ast_parse(q.query);
+            assert(parsed.type == RES_OK);
+            EvalResult res = eval(parsed.node, input.result);
+            assert(res.type == RES_OK);
+            json_free(res.json);
+        });
+        bench_report(name, corpus.length, corpus.elements, ns);
+
+        json_free(input.result);
+        jrq_free(corpus.data);
+    }
+    return 0;
+}
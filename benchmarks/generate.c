@@ -0,0 +1,20 @@
+#include "bench.h"
+#include "corpus.h"
+#include "src/alloc.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/// Writes a corpus to stdout, so that the same inputs the benchmarks use can be given to jrq.
+int main(int argc, char **argv) {
+    int kind = argc > 1 ? corpus_from_name(argv[1]) : -1;
+    if (kind == -1) {
+        fprintf(stderr, "Usage: %s <wide|deep|numeric|logs|ndjson> [bytes]\n", argv[0]);
+        return 2;
+    }
+
+    size_t bytes = argc > 2 ? strtoull(argv[2], NULL, 10) : bench_corpus_bytes();
+    Corpus corpus = corpus_generate(kind, bytes);
+    fwrite(corpus.data, 1, corpus.length, stdout);
+    jrq_free(corpus.data);
+    return 0;
+}
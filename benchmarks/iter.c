@@ -0,0 +1,82 @@
+#include "bench.h"
+#include "src/json.h"
+#include "src/json_iter.h"
+#include <assert.h>
+#include <stdlib.h>
+
+#define ELEMENTS 1000000
+
+static Json identity(Json j, void *captures) {
+    return j;
+}
+
+static bool is_even(Json j, void *captures) {
+    return (long)json_get_number(j) % 2 == 0;
+}
+
+static bool always(Json j, void *captures) {
+    return true;
+}
+
+static bool never(Json j, void *captures) {
+    return false;
+}
+
+/// Drains `iter`, returning the amount of elements it yielded.
+static size_t drain(JsonIterator iter) {
+    size_t count = 0;
+    for (IterOption o = iter_next(iter); o.type == ITER_SOME; o = iter_next(iter)) {
+        json_free(o.some);
+        count++;
+    }
+    iter_free(iter);
+    return count;
+}
+
+#define BENCH_ITER(name, make_iter)                                                                \
+    do {                                                                                           \
+        size_t count = 0;                                                                          \
+        double ns;                                                                                 \
+        bench_run(ns, { count = drain(make_iter); });                                              \
+        bench_report(name, 0, count, ns);                                                          \
+    } while (0)
+
+int main(void) {
+    Json list = json_list_sized(ELEMENTS);
+    Json object = json_object();
+    String text = string_from_chars_alloc("");
+    for (int i = 0; i < ELEMENTS; i++) {
+        list = json_list_append(list, json_number(i));
+        if (i < ELEMENTS / 10) {
+            char key[32];
+            snprintf(key, sizeof(key), "key_%d", i);
+            object = json_object_set(object, json_string(key), json_number(i));
+            string_printf(&text, "%sword%d", i == 0 ? "" : " ", i % 100);
+        }
+    }
+    Json string = json_string_from(text);
+
+    BENCH_ITER("iter_list", iter_list(json_copy(list)));
+    BENCH_ITER("iter_obj_keys", iter_obj_keys(json_copy(object)));
+    BENCH_ITER("iter_obj_values", iter_obj_values(json_copy(object)));
+    BENCH_ITER("iter_obj_key_value", iter_obj_key_value(json_copy(object)));
+    BENCH_ITER("iter_map", iter_map(iter_list(json_copy(list)), identity, NULL, false));
+    BENCH_ITER("iter_filter", iter_filter(iter_list(json_copy(list)), is_even, NULL, false));
+    BENCH_ITER("iter_enumerate", iter_enumerate(iter_list(json_copy(list))));
+    BENCH_ITER("iter_zip", iter_zip(iter_list(json_copy(list)), iter_list(json_copy(list))));
+    BENCH_ITER("iter_skip_while", iter_skip_while(iter_list(json_copy(list)), never, NULL, false));
+    BENCH_ITER("iter_take_while", iter_take_while(iter_list(json_copy(list)), always, NULL, false));
+    BENCH_ITER("iter_skip", iter_skip(iter_list(json_copy(list)), ELEMENTS / 2));
+    BENCH_ITER("iter_take", iter_take(iter_list(json_copy(list)), ELEMENTS / 2));
+    BENCH_ITER("iter_chain", iter_chain(iter_list(json_copy(list)), iter_list(json_copy(list))));
+    BENCH_ITER("iter_split", iter_split(json_copy(string), json_string(" ")));
+
+    double ns;
+    bench_run(ns, { json_free(iter_collect(iter_list(json_copy(list)))); });
+    bench_report("iter_collect", 0, ELEMENTS, ns);
+
+    json_free(list);
+    json_free(object);
+    json_free(string);
+    return 0;
+}
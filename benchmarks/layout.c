@@ -0,0 +1,67 @@
+#include "bench.h"
+#include "corpus.h"
+#include "src/json.h"
+#include "src/json_serde.h"
+#include <assert.h>
+#include <stdlib.h>
+
+/// Walks all of `j`, returning the sum of its numbers so that nothing can be skipped.
+static double walk(Json j) {
+    double sum = 0;
+    switch (json_get_type(j)) {
+    case JSON_TYPE_NUMBER:
+        return json_get_number(j);
+    case JSON_TYPE_LIST: {
+        JsonList *list = json_get_list(j);
+        for (size_t i = 0; i < list->length; i++) {
+            sum += walk(list->data[i]);
+        }
+        return sum;
+    }
+    case JSON_TYPE_OBJECT: {
+        JsonObject *obj = json_get_object(j);
+        for (size_t i = 0; i < obj->length; i++) {
+            sum += walk(obj->data[i].value);
+        }
+        return sum;
+    }
+    default:
+        return 0;
+    }
+}
+
+/// Benchmarks walking `j`, the name says which layout of `Json` was used.
+static void bench_walk(const char *test, Json j, size_t bytes, size_t elements) {
+    char name[128];
+    snprintf(name, sizeof(name), "layout_%s_json%zu", test, sizeof(Json));
+
+    double ns;
+    volatile double sum;
+    bench_run(ns, { sum = walk(j); });
+    (void)sum;
+    bench_report(name, bytes, elements, ns);
+}
+
+int main(void) {
+    // A flat list of numbers, which is as big as the list's buffer
+    size_t numbers = bench_corpus_bytes();
+    Json list = json_list_sized(numbers);
+    for (size_t i = 0; i < numbers; i++) {
+        list = json_list_append(list, json_number((double)i));
+    }
+    bench_walk("scan", list, numbers * sizeof(Json), numbers);
+    json_free(list);
+
+    static const CorpusKind KINDS[] = {CORPUS_NUMERIC, CORPUS_WIDE, CORPUS_DEEP};
+    for (size_t i = 0; i < sizeof(KINDS) / sizeof(*KINDS); i++) {
+        Corpus corpus = corpus_generate(KINDS[i], bench_corpus_bytes());
+        DeserializeResult res = json_deserialize(corpus.data);
+        assert(res.type == RES_OK);
+
+        bench_walk(corpus_name(KINDS[i]), res.result, corpus.length, corpus.elements);
+
+        json_free(res.result);
+        jrq_free(corpus.data);
+    }
+    return 0;
+}
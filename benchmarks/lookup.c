@@ -0,0 +1,54 @@
+#include "bench.h"
+#include "src/json.h"
+#include <assert.h>
+#include <stdlib.h>
+
+#define LOOKUPS 100000
+
+/// Looks up fields of an object with `fields` keys that all start the same and are mostly the same
+/// length, which is the worst case for comparing keys.
+static void bench_lookup(size_t fields) {
+    Json object = json_object();
+    Json *keys = jrq_malloc(fields * sizeof(*keys));
+    for (size_t i = 0; i < fields; i++) {
+        char key[64];
+        snprintf(key, sizeof(key), "some_long_field_name_%zu", i);
+        keys[i] = json_string(key);
+        object = json_object_set(object, json_copy(keys[i]), json_number(i));
+    }
+    Json missing = json_string("some_long_field_name_missing");
+
+    char name[128];
+    double ns;
+
+    snprintf(name, sizeof(name), "lookup_hit_%zu", fields);
+    bench_run(ns, {
+        for (size_t i = 0; i < LOOKUPS; i++) {
+            Json value = json_object_get(object, keys[i % fields]);
+            assert(json_get_type(value) == JSON_TYPE_NUMBER);
+        }
+    });
+    bench_report(name, 0, LOOKUPS, ns);
+
+    snprintf(name, sizeof(name), "lookup_miss_%zu", fields);
+    bench_run(ns, {
+        for (size_t i = 0; i < LOOKUPS; i++) {
+            assert(json_is_null(json_object_get(object, missing)));
+        }
+    });
+    bench_report(name, 0, LOOKUPS, ns);
+
+    for (size_t i = 0; i < fields; i++) {
+        json_free(keys[i]);
+    }
+    jrq_free(keys);
+    json_free(missing);
+    json_free(object);
+}
+
+int main(void) {
+    bench_lookup(4);
+    bench_lookup(16);
+    bench_lookup(64);
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include "bench.h"
+#include "corpus.h"
+#include "src/json.h"
+#include "src/json_serde.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const CorpusKind KINDS[] = {CORPUS_WIDE, CORPUS_DEEP, CORPUS_LOGS};
+
+static void bench_flags(Corpus corpus, const char *kind, Json *json) {
+    // Every combination of the flags that change how values are written
+    for (JsonSerializeFlags flags = 0; flags < 16; flags++) {
+        size_t bytes = 0;
+        double ns;
+        bench_run(ns, {
+            char *out = json_serialize(json, flags);
+            bytes = strlen(out);
+            jrq_free(out);
+        });
+
+        char name[128];
+        snprintf(
+            name,
+            sizeof(name),
+            "serialize_%s%s%s%s%s",
+            kind,
+            flags & JSON_FLAG_TAB ? "_tab" : "",
+            flags & JSON_FLAG_COLORS ? "_colors" : "",
+            flags & JSON_FLAG_SPACES ? "_spaces" : "",
+            flags & JSON_FLAG_ASCII ? "_ascii" : ""
+        );
+        bench_report(name, bytes, corpus.elements, ns);
+    }
+}
+
+int main(void) {
+    for (size_t i = 0; i < sizeof(KINDS) / sizeof(*KINDS); i++) {
+        Corpus corpus = corpus_generate(KINDS[i], bench_corpus_bytes());
+        DeserializeResult res = json_deserialize(corpus.data);
+        assert(res.type == RES_OK);
+
+        bench_flags(corpus, corpus_name(KINDS[i]), &res.result);
+
+        json_free(res.result);
+        jrq_free(corpus.data);
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include "bench.h"
+#include "src/json.h"
+#include "src/json_iter.h"
+#include "src/json_sort.h"
+#include <assert.h>
+#include <stdlib.h>
+
+#define RECORDS 10000000
+
+/// Sorts `records` by the field `field`, looking the key of every record up once like `sort_by`
+/// does. The records are shared with the caller, so the sorted list is a new one.
+static void bench_sort_by(const char *name, Json records, const char *field) {
+    Json key = json_string(field);
+    size_t length = json_list_length(records);
+    double ns;
+    bench_run(ns, {
+        Json keys = json_list_sized(length);
+        for (size_t i = 0; i < length; i++) {
+            Json record = json_list_get(records, i);
+            keys = json_list_append(keys, json_copy(json_object_get(record, key)));
+        }
+        Json sorted = json_list_sort_by(json_copy(records), keys, false);
+        assert(json_list_length(sorted) == length);
+        json_free(sorted);
+    });
+    json_free(key);
+    bench_report(name, 0, length, ns);
+}
+
+static Json field_of(Json record, void *key) {
+    Json value = json_copy(json_object_get(record, *(Json *)key));
+    json_free(record);
+    return value;
+}
+
+/// Finds the 10 records with the largest `field`, which only ever keeps 10 of them.
+static void bench_top_k(const char *name, Json records, const char *field) {
+    Json key = json_string(field);
+    double ns;
+    bench_run(ns, {
+        Json top = iter_top_k(iter_list(json_copy(records)), 10, &field_of, &key, true);
+        assert(json_list_length(top) == 10);
+        json_free(top);
+    });
+    json_free(key);
+    bench_report(name, 0, json_list_length(records), ns);
+}
+
+/// Adds a field without looking for one with the same key, the keys are shared between records.
+static void add_field(Json record, Json key, Json value) {
+    vec_append(*json_get_object(record), (JsonObjectPair) {.key = json_copy(key), .value = value});
+}
+
+int main(void) {
+    Json id_key = json_string("id");
+    Json score_key = json_string("score");
+    Json name_key = json_string("name");
+
+    // Keys are spread out over the records, with every score showing up ten times
+    Json records = json_list_sized(RECORDS);
+    for (long i = 0; i < RECORDS; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "user_%07ld", (i * 7919) % RECORDS);
+
+        Json record = json_object_sized(3);
+        add_field(record, id_key, json_number(i));
+        add_field(record, score_key, json_number((i * 7919) % (RECORDS / 10)));
+        add_field(record, name_key, json_string(name));
+        records = json_list_append(records, record);
+    }
+
+    bench_sort_by("sort_by_number_10m", records, "score");
+    bench_sort_by("sort_by_string_10m", records, "name");
+    bench_top_k("top_10_by_number_10m", records, "score");
+    bench_top_k("top_10_by_string_10m", records, "name");
+
+    json_free(records);
+    json_free(id_key);
+    json_free(score_key);
+    json_free(name_key);
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include "bench.h"
+#include "src/json.h"
+#include "src/json_iter.h"
+#include <assert.h>
+#include <stdlib.h>
+
+static const char *WORDS[] = {
+    "request", "handled", "user", "timeout", "cache", "miss", "retrying", "connection", "ok",
+};
+
+/// Text of `bytes` bytes made of lines of comma separated words, like a dump of log lines.
+static Json make_text(size_t bytes) {
+    String text = string_from_chars_alloc("");
+    srand(42);
+    while (text.length < bytes) {
+        int words = 4 + rand() % 12;
+        for (int i = 0; i < words; i++) {
+            string_printf(&text, "%s%s", i == 0 ? "" : ", ", WORDS[rand() % 9]);
+        }
+        string_printf(&text, "\n");
+    }
+    return json_string_from(text);
+}
+
+/// Splits `text` by `separator`, either by taking the substrings one by one or by collecting them.
+static void bench_split(const char *name, Json text, const char *separator, bool collect) {
+    size_t count = 0;
+    double ns;
+    bench_run(ns, {
+        JsonIterator iter = iter_split(json_copy(text), json_string(separator));
+        if (collect) {
+            Json list = iter_collect(iter);
+            count = json_list_length(list);
+            json_free(list);
+        } else {
+            count = 0;
+            for (IterOption o = iter_next(iter); o.type == ITER_SOME; o = iter_next(iter)) {
+                json_free(o.some);
+                count++;
+            }
+            iter_free(iter);
+        }
+    });
+    assert(count > 0);
+    bench_report(name, json_string_length(text), count, ns);
+}
+
+int main(void) {
+    // `JRQ_BENCH_BYTES=1073741824` splits a gigabyte of text
+    Json text = make_text(bench_corpus_bytes());
+
+    bench_split("split_newline", text, "\n", false);
+    bench_split("split_comma", text, ", ", false);
+    bench_split("split_newline_collect", text, "\n", true);
+    bench_split("split_comma_collect", text, ", ", true);
+
+    json_free(text);
+    return 0;
+}
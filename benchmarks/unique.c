@@ -0,0 +1,46 @@
+#include "bench.h"
+#include "src/json.h"
+#include "src/json_iter.h"
+#include <assert.h>
+#include <stdlib.h>
+
+#define ELEMENTS 10000000
+
+/// Drains `iter`, returning the amount of elements it yielded.
+static size_t drain(JsonIterator iter) {
+    size_t count = 0;
+    for (IterOption o = iter_next(iter); o.type == ITER_SOME; o = iter_next(iter)) {
+        json_free(o.some);
+        count++;
+    }
+    iter_free(iter);
+    return count;
+}
+
+/// Deduplicates `list`, which has `distinct` different values.
+static void bench_unique(const char *name, Json list, size_t distinct) {
+    size_t count = 0;
+    double ns;
+    bench_run(ns, { count = drain(iter_unique(iter_list(json_copy(list)), NULL, NULL, false)); });
+    assert(count == distinct);
+    bench_report(name, 0, json_list_length(list), ns);
+}
+
+int main(void) {
+    Json numbers = json_list_sized(ELEMENTS);
+    Json strings = json_list_sized(ELEMENTS);
+    for (int i = 0; i < ELEMENTS; i++) {
+        numbers = json_list_append(numbers, json_number((i * 7919L) % 1000000));
+        char key[32];
+        snprintf(key, sizeof(key), "user_%ld", (i * 7919L) % 100000);
+        strings = json_list_append(strings, json_string(key));
+    }
+
+    // Every value shows up ten times, spread out over the list
+    bench_unique("unique_numbers_1m_distinct", numbers, 1000000);
+    bench_unique("unique_strings_100k_distinct", strings, 100000);
+
+    json_free(numbers);
+    json_free(strings);
+    return 0;
+}
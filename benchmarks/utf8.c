@@ -0,0 +1,49 @@
+#include "bench.h"
+#include "src/json.h"
+#include <assert.h>
+#include <stdlib.h>
+
+static const char *PIECES[] = {
+    "東京", "ログ", "エラー", "request", "handled", "用户", "timeout", "数据库", "ok", "😀",
+};
+
+/// Text of `bytes` bytes of words that are a mix of ascii, CJK and emoji.
+static Json make_text(size_t bytes, bool ascii) {
+    String text = string_from_chars_alloc("");
+    srand(42);
+    while (text.length < bytes) {
+        const char *piece = PIECES[rand() % 10];
+        if (ascii && (unsigned char)piece[0] >= 0x80) {
+            continue;
+        }
+        string_printf(&text, "%s ", piece);
+    }
+    return json_string_from(text);
+}
+
+int main(void) {
+    size_t bytes = bench_corpus_bytes();
+    Json mixed = make_text(bytes, false);
+    Json ascii = make_text(bytes, true);
+    size_t codepoints = json_string_codepoints(mixed);
+    double ns;
+
+    size_t count = 0;
+    bench_run(ns, { count = string_codepoints(*json_get_string(mixed)); });
+    assert(count == codepoints);
+    bench_report("codepoints_mixed", json_string_length(mixed), count, ns);
+
+    bench_run(ns, { count = string_codepoints(*json_get_string(ascii)); });
+    bench_report("codepoints_ascii", json_string_length(ascii), count, ns);
+
+    // Only the first call counts, after that the string is known to be ascii
+    bench_run(ns, { count = json_string_codepoints(ascii); });
+    bench_report("codepoints_ascii_cached", json_string_length(ascii), count, ns);
+
+    bench_run(ns, { json_free(json_string_slice(mixed, codepoints / 2, codepoints / 2 + 10)); });
+    bench_report("slice_mixed_middle", json_string_length(mixed) / 2, 1, ns);
+
+    json_free(mixed);
+    json_free(ascii);
+    return 0;
+}
@@ -1,49 +1,236 @@
 #include "alloc.h"
+#include <malloc.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-static void out_of_memory() {
+size_t jrq_allocations = 0;
+size_t jrq_allocated_bytes = 0;
+size_t jrq_size_classes[JRQ_SIZE_CLASSES] = {0};
+size_t jrq_live_bytes = 0;
+size_t jrq_peak_bytes = 0;
+size_t jrq_mem_limit = 0;
+
+static void abort_out_of_memory(size_t size) {
+    (void)size;
     fprintf(stderr, "Out of memory :skull:");
     abort();
 }
 
+void (*jrq_out_of_memory)(size_t size) = abort_out_of_memory;
+
+/// The counters are shared by every thread, like the parallel deserializer's workers, so they're
+/// updated atomically. Relaxed is enough since they're only read once the threads are done.
+static void count(size_t size) {
+    __atomic_fetch_add(&jrq_allocations, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&jrq_allocated_bytes, size, __ATOMIC_RELAXED);
+}
+
+static void *counting_malloc(size_t size) {
+    count(size);
+    return malloc(size);
+}
+
+static void *counting_calloc(size_t amt, size_t size) {
+    count(amt * size);
+    return calloc(amt, size);
+}
+
+static void *counting_realloc(void *ptr, size_t size) {
+    count(size);
+    return realloc(ptr, size);
+}
+
+static void *counting_aligned_alloc(size_t alignment, size_t size) {
+    count(size);
+    return aligned_alloc(alignment, size);
+}
+
+const JrqAllocator JRQ_ALLOCATOR_LIBC = {"libc", malloc, calloc, realloc, free, aligned_alloc};
+
+const JrqAllocator JRQ_ALLOCATOR_COUNTING = {
+    "counting",
+    counting_malloc,
+    counting_calloc,
+    counting_realloc,
+    free,
+    counting_aligned_alloc,
+};
+
+static void count_size_class(size_t size) {
+    size_t class = size == 0 ? 0 : 64 - __builtin_clzll(size);
+    size_t *counter = &jrq_size_classes[class < JRQ_SIZE_CLASSES ? class : JRQ_SIZE_CLASSES - 1];
+    __atomic_fetch_add(counter, 1, __ATOMIC_RELAXED);
+}
+
+static void *histogram_malloc(size_t size) {
+    count_size_class(size);
+    return counting_malloc(size);
+}
+
+static void *histogram_calloc(size_t amt, size_t size) {
+    count_size_class(amt * size);
+    return counting_calloc(amt, size);
+}
+
+static void *histogram_realloc(void *ptr, size_t size) {
+    count_size_class(size);
+    return counting_realloc(ptr, size);
+}
+
+static void *histogram_aligned_alloc(size_t alignment, size_t size) {
+    count_size_class(size);
+    return counting_aligned_alloc(alignment, size);
+}
+
+const JrqAllocator JRQ_ALLOCATOR_HISTOGRAM = {
+    "histogram",
+    histogram_malloc,
+    histogram_calloc,
+    histogram_realloc,
+    free,
+    histogram_aligned_alloc,
+};
+
+/// Make sure that `grow` more bytes fit in the limit, before they're allocated.
+static bool fits_limit(size_t grow) {
+    size_t live = __atomic_load_n(&jrq_live_bytes, __ATOMIC_RELAXED);
+    return jrq_mem_limit == 0 || live + grow <= jrq_mem_limit;
+}
+
+/// Add `size` bytes that are now in use, and remove `freed` bytes that aren't.
+static void track(size_t size, size_t freed) {
+    size_t live = __atomic_add_fetch(&jrq_live_bytes, size - freed, __ATOMIC_RELAXED);
+    size_t peak = __atomic_load_n(&jrq_peak_bytes, __ATOMIC_RELAXED);
+    while (live > peak
+           && !__atomic_compare_exchange_n(
+               &jrq_peak_bytes, &peak, live, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED
+           )) {
+    }
+}
+
+static void *peak_malloc(size_t size) {
+    if (!fits_limit(size)) {
+        return NULL;
+    }
+    void *p = counting_malloc(size);
+    track(malloc_usable_size(p), 0);
+    return p;
+}
+
+static void *peak_calloc(size_t amt, size_t size) {
+    if (!fits_limit(amt * size)) {
+        return NULL;
+    }
+    void *p = counting_calloc(amt, size);
+    track(malloc_usable_size(p), 0);
+    return p;
+}
+
+static void *peak_realloc(void *ptr, size_t size) {
+    size_t old = malloc_usable_size(ptr);
+    if (size > old && !fits_limit(size - old)) {
+        return NULL;
+    }
+    void *p = counting_realloc(ptr, size);
+    // The old memory is still in use when growing fails
+    if (p != NULL) {
+        track(malloc_usable_size(p), old);
+    }
+    return p;
+}
+
+static void peak_free(void *ptr) {
+    track(0, malloc_usable_size(ptr));
+    free(ptr);
+}
+
+static void *peak_aligned_alloc(size_t alignment, size_t size) {
+    if (!fits_limit(size)) {
+        return NULL;
+    }
+    void *p = counting_aligned_alloc(alignment, size);
+    track(malloc_usable_size(p), 0);
+    return p;
+}
+
+const JrqAllocator JRQ_ALLOCATOR_PEAK = {
+    "peak",
+    peak_malloc,
+    peak_calloc,
+    peak_realloc,
+    peak_free,
+    peak_aligned_alloc,
+};
+
+static const JrqAllocator *ALLOCATORS[] = {
+    &JRQ_ALLOCATOR_LIBC,
+    &JRQ_ALLOCATOR_COUNTING,
+    &JRQ_ALLOCATOR_HISTOGRAM,
+    &JRQ_ALLOCATOR_PEAK,
+};
+
+static const JrqAllocator *allocator = &JRQ_ALLOCATOR_COUNTING;
+
+void jrq_set_allocator(const JrqAllocator *a) {
+    allocator = a;
+}
+
+const JrqAllocator *jrq_allocator_from_name(const char *name) {
+    for (size_t i = 0; i < sizeof(ALLOCATORS) / sizeof(*ALLOCATORS); i++) {
+        if (strcmp(ALLOCATORS[i]->name, name) == 0) {
+            return ALLOCATORS[i];
+        }
+    }
+    return NULL;
+}
+
 void *jrq_malloc(size_t size) {
-    void *p = malloc(size);
+    void *p = allocator->malloc(size);
     if (!p) {
-        out_of_memory();
+        jrq_out_of_memory(size);
     }
     return p;
 }
 
 void *jrq_calloc(size_t amt, size_t size) {
-    void *p = calloc(size, amt);
+    void *p = allocator->calloc(amt, size);
     if (!p) {
-        out_of_memory();
+        jrq_out_of_memory(amt * size);
     }
     return p;
 }
 
 void *jrq_realloc(void *ptr, size_t size) {
-    void *p = realloc(ptr, size);
+    void *p = allocator->realloc(ptr, size);
     if (!p) {
-        out_of_memory();
+        jrq_out_of_memory(size);
     }
     return p;
 }
 
-void *jrq_strdup(char *str) {
-    void *p = strdup(str);
+void jrq_free(void *ptr) {
+    if (ptr != NULL) {
+        allocator->free(ptr);
+    }
+}
+
+void *jrq_aligned_alloc(size_t alignment, size_t size) {
+    void *p = allocator->aligned_alloc(alignment, size);
     if (!p) {
-        out_of_memory();
+        jrq_out_of_memory(size);
     }
     return p;
 }
 
+void *jrq_strdup(char *str) {
+    return jrq_strndup(str, strlen(str));
+}
+
 char *jrq_strndup(char *str, size_t size) {
-    char *p = strndup(str, size);
-    if (!p) {
-        out_of_memory();
-    }
+    size = strnlen(str, size);
+    char *p = jrq_malloc(size + 1);
+    memcpy(p, str, size);
+    p[size] = '\0';
     return p;
 }
@@ -1,11 +1,67 @@
 #ifndef _ALLOC_H
 #define _ALLOC_H
 
+#include <stdbool.h>
 #include <stdlib.h>
 
+/// Where the memory of everything jrq allocates comes from.
+///
+/// Every implementation hands out memory from the libc allocator, so memory can be freed by any
+/// of them, but the ones that keep track of how much memory is in use are only right when they're
+/// used from the start.
+typedef struct {
+    const char *name;
+    void *(*malloc)(size_t size);
+    void *(*calloc)(size_t amt, size_t size);
+    void *(*realloc)(void *ptr, size_t size);
+    void (*free)(void *ptr);
+    /// Like C11's `aligned_alloc`, `size` has to be a multiple of `alignment`.
+    void *(*aligned_alloc)(size_t alignment, size_t size);
+} JrqAllocator;
+
+/// Allocates without keeping track of anything.
+extern const JrqAllocator JRQ_ALLOCATOR_LIBC;
+/// Counts allocations in `jrq_allocations` and `jrq_allocated_bytes`, this is the default. jrq
+/// itself only counts when the counts are reported, since every thread shares the counters.
+extern const JrqAllocator JRQ_ALLOCATOR_COUNTING;
+/// Counts like `JRQ_ALLOCATOR_COUNTING` and also how many allocations fall in each size class.
+extern const JrqAllocator JRQ_ALLOCATOR_HISTOGRAM;
+/// Counts like `JRQ_ALLOCATOR_COUNTING` and also keeps track of how much memory is in use and the
+/// most that has been, which is what `jrq_mem_limit` is checked against.
+extern const JrqAllocator JRQ_ALLOCATOR_PEAK;
+
+/// Use `allocator` for all allocations from now on, should be called before anything is allocated.
+void jrq_set_allocator(const JrqAllocator *allocator);
+/// The allocator called `name`, or NULL if there isn't one.
+const JrqAllocator *jrq_allocator_from_name(const char *name);
+
+/// Called instead of returning when an allocation fails or would go over `jrq_mem_limit`, with the
+/// size of the allocation. It must not return, by default it aborts.
+extern void (*jrq_out_of_memory)(size_t size);
+
+/// The amount of allocations made through the functions below so far. It's updated atomically, so
+/// it's exact with several threads allocating as well.
+extern size_t jrq_allocations;
+/// The amount of bytes asked for by those allocations, a `jrq_realloc` counts all of its new size.
+extern size_t jrq_allocated_bytes;
+
+/// Amount of size classes, allocations of `2^(n-1)` up to `2^n - 1` bytes are in class `n`.
+#define JRQ_SIZE_CLASSES 33
+/// How many allocations were made in each size class, the last one has everything bigger as well.
+extern size_t jrq_size_classes[JRQ_SIZE_CLASSES];
+
+/// The bytes that are in use right now and the most that have been, as the libc allocator sees
+/// them, so including its rounding up. These are synchronized.
+extern size_t jrq_live_bytes;
+extern size_t jrq_peak_bytes;
+/// The most bytes that can be in use at once, 0 means there's no limit.
+extern size_t jrq_mem_limit;
+
 void *jrq_malloc(size_t);
 void *jrq_calloc(size_t, size_t);
 void *jrq_realloc(void *, size_t);
+void jrq_free(void *);
+void *jrq_aligned_alloc(size_t, size_t);
 void *jrq_strdup(char *);
 char *jrq_strndup(char *, size_t);
 
@@ -13,12 +13,16 @@
 static const int MARGIN = 30;
 
 JrqError jrq_error(Range r, const char *fmt, ...) {
-    va_list args;
-    va_start(args, fmt);
+    va_list args1, args2;
+    va_start(args1, fmt);
+    va_copy(args2, args1);
 
-    char *msg;
-    vasprintf(&msg, fmt, args);
-    va_end(args);
+    int length = vsnprintf(NULL, 0, fmt, args1) + 1;
+    char *msg = jrq_malloc(length);
+    vsnprintf(msg, length, fmt, args2);
+
+    va_end(args1);
+    va_end(args2);
 
     return (JrqError) {.range = r, .err = msg};
 }
@@ -143,12 +147,12 @@ char *jrq_error_format(JrqError err, char *text) {
         (int)(offset + data.width - 1), arrow_txt /* */
 
     int length = snprintf(NULL, 0, ERROR);
-    char *v = malloc(length);
+    char *v = jrq_malloc(length);
     snprintf(v, length, ERROR);
 #undef ERROR
 
-    free(err.err);
-    free(arrow_txt);
+    jrq_free(err.err);
+    jrq_free(arrow_txt);
 
     return v;
 }
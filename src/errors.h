@@ -35,6 +35,7 @@
 #define EVAL_ERR_SPREAD_LIST(t) TYPE_ERROR("Expected spread operator to be list, got %s", t)
 
 #define EVAL_ERR_LIST_ACCESS(t) TYPE_ERROR("Expected number in list access, got %s", t)
+#define EVAL_ERR_STRING_ACCESS(t) TYPE_ERROR("Expected number in string access, got %s", t)
 #define EVAL_ERR_JSON_ACCESS(t) TYPE_ERROR("Expected string in object access, got %s", t)
 #define EVAL_ERR_INNER_ACCESS(t) TYPE_ERROR("Can not index a %s", t)
 
@@ -62,6 +63,11 @@
     TYPE_ERROR("Invalid arguments to function (expected %s, got %s)", exp, act)
 #define EVAL_ERR_FUNC_WRONG_CALLER(exp, act)                                                       \
     TYPE_ERROR("Invalid caller on function (expected %s, got %s)", exp, act)
+#define EVAL_ERR_FUNC_MISSING_CALLER                                                               \
+    TYPE_ERROR("Missing caller on function (expected a method call like `.foo()`)")
+#define EVAL_ERR_FUNC_UNEXPECTED_CALLER                                                            \
+    TYPE_ERROR("Unexpected caller on function (expected a call without one like `foo()`)")
+#define EVAL_ERR_FUNC_RANGE_STEP RUNTIME_ERROR("Step of range can not be 0")
 #define EVAL_ERR_CLOSURE_RETURN(exp, act)                                                          \
     TYPE_ERROR("Invalid return type from closure (expected, %s, got %s)", exp, act)
 #define EVAL_ERR_VAR_NOT_FOUND(t)                                                                  \
@@ -6,6 +6,7 @@
 #include "src/json_iter.h"
 #include "src/lexer.h"
 #include "src/parser.h"
+#include "src/projection.h"
 
 typedef struct {
     union {
@@ -13,8 +14,24 @@ typedef struct {
         Json json;
     };
     JrqResult type;
+
+    /// Whether the result was passed to an `EvalStreamFunc` instead of being returned
+    bool streamed;
 } EvalResult;
 
+typedef void (*EvalStreamFunc)(Json, void *);
+
+/// Where the time and allocations of evaluating a query go, per node of the query.
+typedef struct Profile Profile;
+
 EvalResult eval(ASTNode *node, Json input);
+EvalResult eval_stream(
+    ASTNode *node, Json input, EvalStreamFunc each, void *data, Profile *profile
+);
+Projection *eval_projection(ASTNode *node);
+
+Profile *profile_new(ASTNode *node);
+char *profile_format(Profile *profile, char *code);
+void profile_free(Profile *profile);
 
 #endif // _EVAL_H
@@ -22,7 +22,7 @@ JsonIterator eval_to_iter(Eval *e, EvalData d) {
     if (d.type == SOME_ITER) {
         return d.iter;
     }
-    switch (d.json.type) {
+    switch (json_get_type(d.json)) {
     case JSON_TYPE_LIST:
         return iter_list(d.json);
     case JSON_TYPE_OBJECT:
@@ -45,24 +45,64 @@ void free_eval_data(EvalData *e) {
 }
 
 EvalResult eval(ASTNode *node, Json input) {
+    return eval_stream(node, input, NULL, NULL, NULL);
+}
+
+/// Evaluates `node` like `eval`, but if it evaluates to an iterator and `each` isn't NULL, each of
+/// its elements is passed to `each` as soon as it's produced instead of being collected into a
+/// list. `each` takes ownership of the elements. The result is then `streamed` and has no json.
+///
+/// If `profile` isn't NULL, the time spent evaluating each node of `node` is recorded in it.
+EvalResult eval_stream(
+    ASTNode *node, Json input, EvalStreamFunc each, void *data, Profile *profile
+) {
     Eval e = (Eval) {
         .input = input,
         .err = {0},
+        .profile = profile,
     };
 
     EvalData j = eval_node(&e, node);
-    Json result = eval_to_json(&e, j);
+
+    // Most of the work of an iterator happens once it's consumed, which belongs to the node that
+    // made the iterator.
+    if (profile != NULL && node != NULL) {
+        profile_enter(profile, node, false);
+    }
+
+    bool streamed = each != NULL && j.type == SOME_ITER && e.err.err == NULL;
+    Json result = json_null();
+    if (streamed) {
+        for (IterOption o = iter_next(j.iter); o.type == ITER_SOME; o = iter_next(j.iter)) {
+            // The element that caused an error is only a placeholder
+            if (e.err.err != NULL) {
+                json_free(o.some);
+                break;
+            }
+            each(o.some, data);
+        }
+        iter_free(j.iter);
+    } else {
+        result = eval_to_json(&e, j);
+    }
+
+    if (profile != NULL) {
+        if (node != NULL) {
+            profile_exit(profile);
+        }
+        profile_finish(profile);
+    }
     ast_free(node);
 
     assert(e.vs.length == 0);
     if (e.vs.data != NULL) {
-        free(e.vs.data);
+        jrq_free(e.vs.data);
     }
 
     if (e.err.err != NULL) {
         json_free(result);
         return (EvalResult) {.err = e.err, .type = RES_ERR};
     } else {
-        return (EvalResult) {.json = result, .type = RES_OK};
+        return (EvalResult) {.json = result, .type = RES_OK, .streamed = streamed};
     }
 }
@@ -3,6 +3,9 @@
 #include "src/eval/private.h"
 #include "src/json.h"
 #include "src/json_iter.h"
+#include "src/json_serde.h"
+#include "src/json_sort.h"
+#include "src/json_table.h"
 #include "src/parser.h"
 #include "src/utils.h"
 #include "src/vector.h"
@@ -47,7 +50,7 @@ static bool closure_returns_bool(Json j, void *aux) {
 
     EXPECT_TYPE(
         c->e,
-        ret.type,
+        json_get_type(ret),
         JSON_TYPE_BOOL,
         EVAL_ERR_CLOSURE_RETURN(JSON_TYPE(JSON_TYPE_BOOL), json_type(ret))
     );
@@ -80,7 +83,7 @@ bool iter_eval_func(
     // Safe to get iter here because we already made sure there were no errors
     *iter = i.iter;
 
-    struct simple_closure *c = malloc(sizeof(*c));
+    struct simple_closure *c = jrq_malloc(sizeof(*c));
 
     *c = (struct simple_closure) {
         .e = e,
@@ -129,6 +132,378 @@ JsonIterator eval_func_filter(Eval *e, ASTNode *node) {
     return iter_filter(iter, &closure_returns_bool, c, true);
 }
 
+static struct function_data FUNC_UNIQUE = {
+    .function_name = "unique",
+    .caller_type = JSON_TYPE_ITERATOR,
+
+    .parameter_types = (JsonType[]) {},
+    .parameter_amount = 0,
+};
+JsonIterator eval_func_unique(Eval *e, ASTNode *node) {
+    EvalData i = func_expect_args(e, node, NULL, FUNC_UNIQUE);
+    if (eval_has_err(e)) {
+        return NULL;
+    }
+    return iter_unique(i.iter, NULL, NULL, false);
+}
+
+static struct function_data FUNC_UNIQUE_BY = {
+    .function_name = "unique_by",
+    .caller_type = JSON_TYPE_ITERATOR,
+
+    .parameter_types = (JsonType[]) {JSON_TYPE_CLOSURE_WITH_PARAMS(1)},
+    .parameter_amount = 1,
+};
+JsonIterator eval_func_unique_by(Eval *e, ASTNode *node) {
+    Json evaled_args[1] = {0};
+    JsonIterator iter;
+    struct simple_closure *c;
+
+    if (!iter_eval_func(e, node, FUNC_UNIQUE_BY, evaled_args, &iter, &c)) {
+        return NULL;
+    }
+    return iter_unique(iter, &closure_returns_json, c, true);
+}
+
+/// Runs a closure with the two parameters `|acc, v|`, consuming both of them.
+static Json closure_fold(Eval *e, ASTNode *closure, Json acc, Json v) {
+    Vec_ASTNode params = closure->inner.closure.args;
+
+    int pushed = vs_push_closure_variable(e, params.data[0], acc);
+    pushed += vs_push_closure_variable(e, params.data[1], v);
+    Json ret = json_invalid();
+    if (!eval_has_err(e)) {
+        ret = eval_to_json(e, eval_node(e, closure->inner.closure.body));
+    }
+    int popped = vs_pop_closure_variable(e, params.data[1], v);
+    popped += vs_pop_closure_variable(e, params.data[0], acc);
+    assert(pushed == popped);
+
+    json_free(acc);
+    json_free(v);
+    return ret;
+}
+
+/// The name of the field a group is output as, consumes `key`.
+///
+/// The fields of an object are strings, so other keys are written out as json. Numbers are written
+/// out so they read back as the same number, `1` and `"1"` are the same group.
+static Json group_name(Json key) {
+    if (json_get_type(key) == JSON_TYPE_STRING) {
+        return key;
+    }
+
+    Json name;
+    if (json_get_type(key) == JSON_TYPE_NUMBER) {
+        char buf[32];
+        double n = json_get_number(key);
+        snprintf(buf, sizeof(buf), "%.15g", n);
+        if (strtod(buf, NULL) != n) {
+            snprintf(buf, sizeof(buf), "%.17g", n);
+        }
+        name = json_string(buf);
+    } else {
+        char *serialized = json_serialize(&key, 0);
+        name = json_string(serialized);
+        jrq_free(serialized);
+    }
+    json_free(key);
+    return name;
+}
+
+typedef enum {
+    GROUP_LISTS,
+    GROUP_COUNTS,
+    GROUP_FOLD,
+} GroupKind;
+
+/// Puts the elements of the caller into groups by the key the first closure gives them, and
+/// returns an object with a field for every group in the order they were first seen.
+///
+/// Groups are kept in a hash table, and what is kept of a group depends on `kind`: the list of its
+/// elements, how many elements there are, or the result of folding them with the third argument.
+static Json eval_group(Eval *e, ASTNode *node, struct function_data func, GroupKind kind) {
+    Json evaled_args[3] = {0};
+    EvalData d = func_expect_args(e, node, evaled_args, func);
+    if (eval_has_err(e)) {
+        return json_invalid();
+    }
+    JsonIterator iter = d.iter;
+    Vec_ASTNode args = node->inner.function.args;
+
+    struct simple_closure key_closure = {
+        .e = e,
+        .node = args.data[0]->inner.closure.body,
+        .params = args.data[0]->inner.closure.args,
+    };
+
+    JsonTable groups = {0};
+    for (IterOption o = iter_next(iter); o.type == ITER_SOME; o = iter_next(iter)) {
+        Json key = closure_returns_json(json_copy(o.some), &key_closure);
+        if (eval_has_err(e)) {
+            json_free(key);
+            json_free(o.some);
+            break;
+        }
+
+        bool added;
+        JsonTableEntry *group = json_table_entry(&groups, group_name(key), &added);
+        switch (kind) {
+        case GROUP_LISTS:
+            group->value = json_list_append(added ? json_list() : group->value, o.some);
+            break;
+        case GROUP_COUNTS:
+            group->value = json_number(added ? 1 : json_get_number(group->value) + 1);
+            json_free(o.some);
+            break;
+        case GROUP_FOLD: {
+            Json acc = added ? json_copy(evaled_args[1]) : group->value;
+            group->value = closure_fold(e, args.data[2], acc, o.some);
+            break;
+        }
+        }
+    }
+    iter_free(iter);
+    json_free(evaled_args[1]);
+
+    if (eval_has_err(e)) {
+        json_table_free(&groups);
+        return json_invalid();
+    }
+
+    // The keys are all different already, so they don't have to be looked up in the object
+    Json object = json_object_sized(groups.entries.length);
+    for (size_t i = 0; i < groups.entries.length; i++) {
+        JsonTableEntry group = groups.entries.data[i];
+        vec_append(
+            *json_get_object(object), (JsonObjectPair) {.key = group.key, .value = group.value}
+        );
+    }
+    groups.entries.length = 0;
+    json_table_free(&groups);
+    return object;
+}
+
+static struct function_data FUNC_GROUP_BY = {
+    .function_name = "group_by",
+    .caller_type = JSON_TYPE_ITERATOR,
+
+    .parameter_types = (JsonType[]) {JSON_TYPE_CLOSURE_WITH_PARAMS(1)},
+    .parameter_amount = 1,
+};
+Json eval_func_group_by(Eval *e, ASTNode *node) {
+    return eval_group(e, node, FUNC_GROUP_BY, GROUP_LISTS);
+}
+
+static struct function_data FUNC_COUNT_BY = {
+    .function_name = "count_by",
+    .caller_type = JSON_TYPE_ITERATOR,
+
+    .parameter_types = (JsonType[]) {JSON_TYPE_CLOSURE_WITH_PARAMS(1)},
+    .parameter_amount = 1,
+};
+Json eval_func_count_by(Eval *e, ASTNode *node) {
+    return eval_group(e, node, FUNC_COUNT_BY, GROUP_COUNTS);
+}
+
+static struct function_data FUNC_AGGREGATE = {
+    .function_name = "aggregate",
+    .caller_type = JSON_TYPE_ITERATOR,
+
+    .parameter_types = (JsonType[]) {
+        JSON_TYPE_CLOSURE_WITH_PARAMS(1),
+        JSON_TYPE_ANY,
+        JSON_TYPE_CLOSURE_WITH_PARAMS(2),
+    },
+    .parameter_amount = 3,
+};
+Json eval_func_aggregate(Eval *e, ASTNode *node) {
+    return eval_group(e, node, FUNC_AGGREGATE, GROUP_FOLD);
+}
+
+static struct function_data FUNC_SORT = {
+    .function_name = "sort",
+    .caller_type = JSON_TYPE_LIST,
+
+    .parameter_types = (JsonType[]) {},
+    .parameter_amount = 0,
+};
+Json eval_func_sort(Eval *e, ASTNode *node) {
+    EvalData caller = func_expect_args(e, node, NULL, FUNC_SORT);
+    if (eval_has_err(e)) {
+        return json_invalid();
+    }
+    return json_list_sort(caller.json, false);
+}
+
+static struct function_data FUNC_SORT_DESC = {
+    .function_name = "sort_desc",
+    .caller_type = JSON_TYPE_LIST,
+
+    .parameter_types = (JsonType[]) {},
+    .parameter_amount = 0,
+};
+Json eval_func_sort_desc(Eval *e, ASTNode *node) {
+    EvalData caller = func_expect_args(e, node, NULL, FUNC_SORT_DESC);
+    if (eval_has_err(e)) {
+        return json_invalid();
+    }
+    return json_list_sort(caller.json, true);
+}
+
+static struct function_data FUNC_SORT_BY = {
+    .function_name = "sort_by",
+    .caller_type = JSON_TYPE_LIST,
+
+    .parameter_types = (JsonType[]) {JSON_TYPE_CLOSURE_WITH_PARAMS(1)},
+    .parameter_amount = 1,
+};
+Json eval_func_sort_by(Eval *e, ASTNode *node) {
+    Json evaled_args[1] = {0};
+    EvalData caller = func_expect_args(e, node, evaled_args, FUNC_SORT_BY);
+    if (eval_has_err(e)) {
+        return json_invalid();
+    }
+    Json list = caller.json;
+    ASTNode *closure = node->inner.function.args.data[0];
+    struct simple_closure c = {
+        .e = e,
+        .node = closure->inner.closure.body,
+        .params = closure->inner.closure.args,
+    };
+
+    // The keys are computed once, instead of every time two elements are compared
+    size_t length = json_list_length(list);
+    Json keys = json_list_sized(length);
+    for (size_t i = 0; i < length; i++) {
+        keys = json_list_append(keys, closure_returns_json(json_copy(json_list_get(list, i)), &c));
+        if (eval_has_err(e)) {
+            json_free(keys);
+            json_free(list);
+            return json_invalid();
+        }
+    }
+    return json_list_sort_by(list, keys, false);
+}
+
+/// How many elements `.top_k(k, ...)` and `.take(k)` keep, none if `k` isn't positive.
+static size_t keep_amount(double k) {
+    return k > 0 ? (size_t)k : 0;
+}
+
+/// The `k` elements with the largest keys, or the smallest if `largest` isn't set, which are found
+/// with a heap of k elements.
+static Json eval_top_k(Eval *e, ASTNode *node, struct function_data func, bool largest) {
+    Json evaled_args[2] = {0};
+    EvalData caller = func_expect_args(e, node, evaled_args, func);
+    if (eval_has_err(e)) {
+        return json_invalid();
+    }
+    ASTNode *closure = node->inner.function.args.data[1];
+    struct simple_closure c = {
+        .e = e,
+        .node = closure->inner.closure.body,
+        .params = closure->inner.closure.args,
+    };
+
+    size_t k = keep_amount(json_get_number(evaled_args[0]));
+    Json top = iter_top_k(caller.iter, k, &closure_returns_json, &c, largest);
+    if (eval_has_err(e)) {
+        json_free(top);
+        return json_invalid();
+    }
+    return top;
+}
+
+static struct function_data FUNC_TOP_K = {
+    .function_name = "top_k",
+    .caller_type = JSON_TYPE_ITERATOR,
+
+    .parameter_types = (JsonType[]) {JSON_TYPE_NUMBER, JSON_TYPE_CLOSURE_WITH_PARAMS(1)},
+    .parameter_amount = 2,
+};
+Json eval_func_top_k(Eval *e, ASTNode *node) {
+    return eval_top_k(e, node, FUNC_TOP_K, true);
+}
+
+static struct function_data FUNC_BOTTOM_K = {
+    .function_name = "bottom_k",
+    .caller_type = JSON_TYPE_ITERATOR,
+
+    .parameter_types = (JsonType[]) {JSON_TYPE_NUMBER, JSON_TYPE_CLOSURE_WITH_PARAMS(1)},
+    .parameter_amount = 2,
+};
+Json eval_func_bottom_k(Eval *e, ASTNode *node) {
+    return eval_top_k(e, node, FUNC_BOTTOM_K, false);
+}
+
+/// Pairs up the elements of the caller with the elements of the list in the first argument that
+/// have the same key, with the keys of each side given by the closures.
+static JsonIterator eval_join_on(
+    Eval *e,
+    ASTNode *node,
+    struct function_data func,
+    bool keep_unmatched
+) {
+    Json evaled_args[3] = {0};
+    EvalData caller = func_expect_args(e, node, evaled_args, func);
+    if (eval_has_err(e)) {
+        return NULL;
+    }
+
+    Vec_ASTNode args = node->inner.function.args;
+    struct simple_closure *keys[2];
+    for (int side = 0; side < 2; side++) {
+        keys[side] = jrq_malloc(sizeof(*keys[side]));
+        *keys[side] = (struct simple_closure) {
+            .e = e,
+            .node = args.data[side + 1]->inner.closure.body,
+            .params = args.data[side + 1]->inner.closure.args,
+        };
+    }
+
+    return iter_join(
+        caller.iter,
+        evaled_args[0],
+        &closure_returns_json,
+        keys[0],
+        &closure_returns_json,
+        keys[1],
+        true,
+        keep_unmatched
+    );
+}
+
+static struct function_data FUNC_JOIN_ON = {
+    .function_name = "join_on",
+    .caller_type = JSON_TYPE_ITERATOR,
+
+    .parameter_types = (JsonType[]) {
+        JSON_TYPE_LIST,
+        JSON_TYPE_CLOSURE_WITH_PARAMS(1),
+        JSON_TYPE_CLOSURE_WITH_PARAMS(1),
+    },
+    .parameter_amount = 3,
+};
+JsonIterator eval_func_join_on(Eval *e, ASTNode *node) {
+    return eval_join_on(e, node, FUNC_JOIN_ON, false);
+}
+
+static struct function_data FUNC_LEFT_JOIN_ON = {
+    .function_name = "left_join_on",
+    .caller_type = JSON_TYPE_ITERATOR,
+
+    .parameter_types = (JsonType[]) {
+        JSON_TYPE_LIST,
+        JSON_TYPE_CLOSURE_WITH_PARAMS(1),
+        JSON_TYPE_CLOSURE_WITH_PARAMS(1),
+    },
+    .parameter_amount = 3,
+};
+JsonIterator eval_func_left_join_on(Eval *e, ASTNode *node) {
+    return eval_join_on(e, node, FUNC_LEFT_JOIN_ON, true);
+}
+
 static struct function_data FUNC_COLLECT = {
     .function_name = "collect",
     .caller_type = JSON_TYPE_ITERATOR,
@@ -178,7 +553,7 @@ JsonIterator eval_func_keys(Eval *e, ASTNode *node) {
     }
 
     Json json = j.json;
-    assert(json.type == JSON_TYPE_OBJECT);
+    assert(json_get_type(json) == JSON_TYPE_OBJECT);
     return iter_obj_keys(json);
 }
 
@@ -199,7 +574,7 @@ JsonIterator eval_func_values(Eval *e, ASTNode *node) {
     }
 
     Json json = j.json;
-    assert(json.type == JSON_TYPE_OBJECT);
+    assert(json_get_type(json) == JSON_TYPE_OBJECT);
     return iter_obj_values(json);
 }
 
@@ -237,7 +612,7 @@ JsonIterator eval_func_zip(Eval *e, ASTNode *node) {
     if (eval_has_err(e)) {
         return NULL;
     }
-    assert(evaled_args[0].type == JSON_TYPE_LIST);
+    assert(json_get_type(evaled_args[0]) == JSON_TYPE_LIST);
 
     JsonIterator a = j.iter;
     // TODO maybe expect_args can expect an iterator type here instead of a
@@ -262,25 +637,28 @@ Json eval_func_sum(Eval *e, ASTNode *node) {
         return json_invalid();
     }
 
-    Json j = d.json;
+    // The caller is streamed, so `range(0, 1000000).sum()` never holds more than one number
+    JsonIterator iter = d.iter;
 
     double sum = 0;
-    for (size_t i = 0; i < json_list_length(j); i++) {
-        Json el = json_list_get(j, i);
+    for (IterOption o = iter_next(iter); o.type == ITER_SOME; o = iter_next(iter)) {
+        Json el = o.some;
         EXPECT_TYPE(
             e,
-            el.type,
+            json_get_type(el),
             JSON_TYPE_NUMBER,
             EVAL_ERR_FUNC_WRONG_ARGS(JSON_TYPE(JSON_TYPE_LIST_T(JSON_TYPE_NUMBER)), json_type(el))
         );
         if (eval_has_err(e)) {
             json_free(el);
+            iter_free(iter);
             return json_invalid();
         }
 
         sum += json_get_number(el);
         json_free(el);
     }
+    iter_free(iter);
 
     return json_number(sum);
 }
@@ -307,7 +685,7 @@ Json eval_func_product(Eval *e, ASTNode *node) {
         Json el = json_list_get(j, i);
         EXPECT_TYPE(
             e,
-            el.type,
+            json_get_type(el),
             JSON_TYPE_NUMBER,
             EVAL_ERR_FUNC_WRONG_ARGS(JSON_TYPE(JSON_TYPE_LIST_T(JSON_TYPE_NUMBER)), json_type(el))
         );
@@ -339,9 +717,9 @@ Json eval_func_flatten(Eval *e, ASTNode *node) {
     }
     assert(d.type == SOME_JSON);
     Json json = d.json;
-    assert(json.type == JSON_TYPE_LIST);
+    assert(json_get_type(json) == JSON_TYPE_LIST);
 
-    switch (json.list_inner_type) {
+    switch (json_list_get_inner_type(json)) {
     case JSON_TYPE_LIST:
         Json list = json_list();
         for (size_t i = 0; i < json_list_length(json); i++) {
@@ -375,7 +753,7 @@ Json eval_func_flatten(Eval *e, ASTNode *node) {
     default:
         EXPECT_TYPE(
             e,
-            json.list_inner_type,
+            json_list_get_inner_type(json),
             -1,
             EVAL_ERR_FUNC_WRONG_CALLER("list[object | list]", json_type(json))
         );
@@ -387,11 +765,85 @@ Json eval_func_flatten(Eval *e, ASTNode *node) {
 
 static struct function_data FUNC_JOIN = {
     .function_name = "join",
-    .caller_type = JSON_TYPE_LIST_T(JSON_TYPE_STRING),
+    .caller_type = JSON_TYPE_ANY,
 
     .parameter_types = (JsonType[]) {JSON_TYPE_STRING},
     .parameter_amount = 1,
 };
+
+/// Joins a list of strings, the length of the result is known up front so it's written into a
+/// buffer of exactly that size.
+static Json join_list(Eval *e, ASTNode *node, Json list, String *separator) {
+    if (json_get_type(list) != JSON_TYPE_LIST
+        || (json_list_length(list) != 0 && json_list_get_inner_type(list) != JSON_TYPE_STRING)) {
+        // Evaluating the separator left the range on it, the caller error is about the whole call
+        e->range = node->range;
+        eval_set_err(
+            e, EVAL_ERR_FUNC_WRONG_CALLER(json_list_type(JSON_TYPE_STRING), json_type(list))
+        );
+        return json_invalid();
+    }
+
+    size_t length = json_list_length(list);
+    size_t total = length > 0 ? (length - 1) * separator->length : 0;
+    for (size_t i = 0; i < length; i++) {
+        total += json_string_length(json_list_get(list, i));
+    }
+
+    String joined = {.data = jrq_malloc(total + 1), .capacity = total + 1};
+    for (size_t i = 0; i < length; i++) {
+        if (i != 0) {
+            memcpy(joined.data + joined.length, separator->data, separator->length);
+            joined.length += separator->length;
+        }
+        String *piece = json_get_string(json_list_get(list, i));
+        memcpy(joined.data + joined.length, piece->data, piece->length);
+        joined.length += piece->length;
+    }
+    joined.data[joined.length] = '\0';
+
+    return json_string_from(joined);
+}
+
+/// Joins the strings an iterator yields as they're produced, so they're never collected into a
+/// list first.
+static Json join_iter(Eval *e, ASTNode *node, JsonIterator iter, String *separator) {
+    String joined = string_from_chars_alloc("");
+    bool first = true;
+
+    for (IterOption o = iter_next(iter); o.type == ITER_SOME; o = iter_next(iter)) {
+        if (eval_has_err(e)) {
+            json_free(o.some);
+            break;
+        }
+        if (json_get_type(o.some) != JSON_TYPE_STRING) {
+            e->range = node->range;
+            eval_set_err(
+                e,
+                EVAL_ERR_FUNC_WRONG_CALLER(
+                    json_list_type(JSON_TYPE_STRING), json_list_type(json_get_type(o.some))
+                )
+            );
+            json_free(o.some);
+            break;
+        }
+
+        if (!first) {
+            string_append(&joined, *separator);
+        }
+        string_append(&joined, *json_get_string(o.some));
+        first = false;
+        json_free(o.some);
+    }
+    iter_free(iter);
+
+    if (eval_has_err(e)) {
+        jrq_free(joined.data);
+        return json_invalid();
+    }
+    return json_string_from(joined);
+}
+
 Json eval_func_join(Eval *e, ASTNode *node) {
     Json evaled_args[1] = {};
 
@@ -399,22 +851,16 @@ Json eval_func_join(Eval *e, ASTNode *node) {
     if (eval_has_err(e)) {
         return json_invalid();
     }
-    assert(d.type == SOME_JSON);
-    Json str_list = d.json;
-    assert(str_list.type == JSON_TYPE_LIST);
-    assert(evaled_args[0].type == JSON_TYPE_STRING);
+    assert(json_get_type(evaled_args[0]) == JSON_TYPE_STRING);
 
-    Json string = json_string("");
+    String *separator = json_get_string(evaled_args[0]);
+    Json string = d.type == SOME_ITER ? join_iter(e, node, d.iter, separator)
+                                      : join_list(e, node, d.json, separator);
 
-    for (size_t i = 0; i < json_list_length(str_list); i++) {
-        if (i != 0) {
-            json_string_concat(string, evaled_args[0]);
-        }
-        json_string_concat(string, json_list_get(str_list, i));
+    if (d.type == SOME_JSON) {
+        json_free(d.json);
     }
-
     json_free(evaled_args[0]);
-    json_free(str_list);
 
     return string;
 }
@@ -436,19 +882,17 @@ Json eval_func_length(Eval *e, ASTNode *node) {
     }
 
     size_t length;
-    switch (j.type) {
+    switch (json_get_type(j)) {
     case JSON_TYPE_LIST:
         length = json_list_length(j);
         json_free(j);
         break;
     case JSON_TYPE_STRING:
-        length = json_string_length(j);
+        length = json_string_codepoints(j);
         json_free(j);
         break;
     default:
-        EXPECT_TYPE(
-            e, j.list_inner_type, -1, EVAL_ERR_FUNC_WRONG_CALLER("string or list", json_type(j))
-        );
+        eval_set_err(e, EVAL_ERR_FUNC_WRONG_CALLER("string or list", json_type(j)));
         json_free(j);
         return json_null();
         break;
@@ -516,10 +960,91 @@ static struct function_data FUNC_TAKE = {
     .parameter_types = (JsonType[]) {JSON_TYPE_NUMBER},
     .parameter_amount = 1,
 };
+/// `.sort()`, `.sort_desc()` and `.sort_by(...)` followed by `.take(k)` only need the first k
+/// elements of the sort, which are found with a heap of k elements instead of sorting all of them.
+///
+/// Returns false if `node` isn't a take of a sort, and has to be evaluated like any other take.
+static bool take_of_sort(Eval *e, ASTNode *node, JsonIterator *result) {
+    Vec_ASTNode args = node->inner.function.args;
+    ASTNode *sort = node->inner.function.callee;
+    if (args.length != 1 || args.data[0]->type == AST_TYPE_CLOSURE || sort == NULL
+        || sort->type != AST_TYPE_FUNCTION) {
+        return false;
+    }
+
+    String name = sort->inner.function.function_name.inner.string;
+    struct function_data func;
+    bool largest = false;
+    if (string_equal(name, string_from_chars("sort"))) {
+        func = FUNC_SORT;
+    } else if (string_equal(name, string_from_chars("sort_desc"))) {
+        func = FUNC_SORT_DESC;
+        largest = true;
+    } else if (string_equal(name, string_from_chars("sort_by"))) {
+        func = FUNC_SORT_BY;
+    } else {
+        return false;
+    }
+
+    *result = NULL;
+    e->range = sort->range;
+    Json evaled_args[1] = {0};
+    // The caller is checked against the sort's own caller type, so this accepts and rejects
+    // exactly what the sort would
+    EvalData list = func_expect_args(e, sort, evaled_args, func);
+    if (eval_has_err(e)) {
+        return true;
+    }
+    assert(list.type == SOME_JSON);
+    JsonIterator caller = iter_list(list.json);
+
+    Json k = eval_to_json(e, eval_node(e, args.data[0]));
+    EXPECT_TYPE(
+        e,
+        json_get_type(k),
+        JSON_TYPE_NUMBER,
+        EVAL_ERR_FUNC_WRONG_ARGS(JSON_TYPE(JSON_TYPE_NUMBER), json_type(k))
+    );
+    if (eval_has_err(e)) {
+        json_free(k);
+        iter_free(caller);
+        return true;
+    }
+
+    Json top;
+    if (sort->inner.function.args.length == 0) {
+        top = iter_top_k(caller, keep_amount(json_get_number(k)), NULL, NULL, largest);
+    } else {
+        ASTNode *closure = sort->inner.function.args.data[0];
+        struct simple_closure c = {
+            .e = e,
+            .node = closure->inner.closure.body,
+            .params = closure->inner.closure.args,
+        };
+        top = iter_top_k(
+            caller, keep_amount(json_get_number(k)), &closure_returns_json, &c, largest
+        );
+    }
+    if (eval_has_err(e)) {
+        json_free(top);
+        return true;
+    }
+    *result = iter_list(top);
+    return true;
+}
+
 JsonIterator eval_func_take(Eval *e, ASTNode *node) {
+    JsonIterator top;
+    if (take_of_sort(e, node, &top)) {
+        return top;
+    }
+
     Json evaled_args[1] = {0};
 
     EvalData d = func_expect_args(e, node, evaled_args, FUNC_TAKE);
+    if (eval_has_err(e)) {
+        return NULL;
+    }
     JsonIterator iter = d.iter;
 
     return iter_take(iter, (int)json_get_number(evaled_args[0]));
@@ -544,6 +1069,30 @@ JsonIterator eval_func_split(Eval *e, ASTNode *node) {
     return iter_split(str, evaled_args[0]);
 }
 
+static struct function_data FUNC_SUBSTRING = {
+    .function_name = "substring",
+    .caller_type = JSON_TYPE_STRING,
+
+    .parameter_types = (JsonType[]) {JSON_TYPE_NUMBER, JSON_TYPE_NUMBER},
+    .parameter_amount = 2,
+};
+/// The codepoints of the caller from the first argument up to the second one.
+Json eval_func_substring(Eval *e, ASTNode *node) {
+    Json evaled_args[2] = {};
+
+    EvalData d = func_expect_args(e, node, evaled_args, FUNC_SUBSTRING);
+    if (eval_has_err(e)) {
+        return json_invalid();
+    }
+    assert(d.type == SOME_JSON);
+
+    double start = json_get_number(evaled_args[0]);
+    double end = json_get_number(evaled_args[1]);
+    Json substring = json_string_slice(d.json, start > 0 ? start : 0, end > 0 ? end : 0);
+    json_free(d.json);
+    return substring;
+}
+
 // This function is necessary, it allows what jq has by piping:
 //
 // .filter(|v| v.bar > 4).and_then(|v| {"foo": v.map(|h| h.foo) + v.map(|h| h.bar})
@@ -603,3 +1152,57 @@ JsonIterator eval_func_chain(Eval *e, ASTNode *node) {
 
     return iter_chain(first, second);
 }
+
+static struct function_data FUNC_RANGE[] = {
+    {
+        .function_name = "range",
+        .caller_type = JSON_TYPE_NO_CALLER,
+
+        .parameter_types = (JsonType[]) {JSON_TYPE_NUMBER},
+        .parameter_amount = 1,
+    },
+    {
+        .function_name = "range",
+        .caller_type = JSON_TYPE_NO_CALLER,
+
+        .parameter_types = (JsonType[]) {JSON_TYPE_NUMBER, JSON_TYPE_NUMBER},
+        .parameter_amount = 2,
+    },
+    {
+        .function_name = "range",
+        .caller_type = JSON_TYPE_NO_CALLER,
+
+        .parameter_types = (JsonType[]) {JSON_TYPE_NUMBER, JSON_TYPE_NUMBER, JSON_TYPE_NUMBER},
+        .parameter_amount = 3,
+    },
+};
+/// `range(end)`, `range(start, end)` or `range(start, end, step)`, where `start` is 0 and `step`
+/// is 1 when they are left out.
+JsonIterator eval_func_range(Eval *e, ASTNode *node) {
+    uint amount = node->inner.function.args.length;
+    // Any other amount of arguments is an error, reported against the closest form
+    uint form = amount == 0 ? 0 : amount > 3 ? 2 : amount - 1;
+
+    Json evaled_args[3] = {0};
+    func_expect_args(e, node, evaled_args, FUNC_RANGE[form]);
+    if (eval_has_err(e)) {
+        return NULL;
+    }
+
+    double start = 0;
+    double end = json_get_number(evaled_args[0]);
+    double step = 1;
+    if (amount >= 2) {
+        start = end;
+        end = json_get_number(evaled_args[1]);
+    }
+    if (amount == 3) {
+        step = json_get_number(evaled_args[2]);
+    }
+
+    if (step == 0) {
+        eval_set_err(e, EVAL_ERR_FUNC_RANGE_STEP);
+        return NULL;
+    }
+    return iter_range(start, end, step);
+}
@@ -10,6 +10,8 @@ JsonIterator eval_func_enumerate(Eval *e, ASTNode *node);
 JsonIterator eval_func_zip(Eval *e, ASTNode *node);
 JsonIterator eval_func_skip_while(Eval *e, ASTNode *node);
 JsonIterator eval_func_take_while(Eval *e, ASTNode *node);
+JsonIterator eval_func_unique(Eval *e, ASTNode *node);
+JsonIterator eval_func_unique_by(Eval *e, ASTNode *node);
 
 Json eval_func_collect(Eval *e, ASTNode *node);
 Json eval_func_sum(Eval *e, ASTNode *node);
@@ -17,8 +19,20 @@ Json eval_func_product(Eval *e, ASTNode *node);
 Json eval_func_flatten(Eval *e, ASTNode *node);
 Json eval_func_join(Eval *e, ASTNode *node);
 Json eval_func_length(Eval *e, ASTNode *node);
+Json eval_func_substring(Eval *e, ASTNode *node);
+Json eval_func_group_by(Eval *e, ASTNode *node);
+Json eval_func_count_by(Eval *e, ASTNode *node);
+Json eval_func_aggregate(Eval *e, ASTNode *node);
+Json eval_func_sort(Eval *e, ASTNode *node);
+Json eval_func_sort_desc(Eval *e, ASTNode *node);
+Json eval_func_sort_by(Eval *e, ASTNode *node);
+Json eval_func_top_k(Eval *e, ASTNode *node);
+Json eval_func_bottom_k(Eval *e, ASTNode *node);
+JsonIterator eval_func_join_on(Eval *e, ASTNode *node);
+JsonIterator eval_func_left_join_on(Eval *e, ASTNode *node);
 
 JsonIterator eval_func_split(Eval *e, ASTNode *node);
 JsonIterator eval_func_take(Eval *e, ASTNode *node);
 JsonIterator eval_func_skip(Eval *e, ASTNode *node);
 Json eval_func_and_then(Eval *e, ASTNode *node);
+JsonIterator eval_func_range(Eval *e, ASTNode *node);
@@ -27,6 +27,30 @@ EvalData eval_node_function(Eval *e, ASTNode *node) {
         return eval_from_iter(eval_func_filter(e, node));
     } else if (string_equal(func_name, string_from_chars("zip"))) {
         return eval_from_iter(eval_func_zip(e, node));
+    } else if (string_equal(func_name, string_from_chars("unique"))) {
+        return eval_from_iter(eval_func_unique(e, node));
+    } else if (string_equal(func_name, string_from_chars("unique_by"))) {
+        return eval_from_iter(eval_func_unique_by(e, node));
+    } else if (string_equal(func_name, string_from_chars("group_by"))) {
+        return eval_from_json(eval_func_group_by(e, node));
+    } else if (string_equal(func_name, string_from_chars("count_by"))) {
+        return eval_from_json(eval_func_count_by(e, node));
+    } else if (string_equal(func_name, string_from_chars("aggregate"))) {
+        return eval_from_json(eval_func_aggregate(e, node));
+    } else if (string_equal(func_name, string_from_chars("sort"))) {
+        return eval_from_json(eval_func_sort(e, node));
+    } else if (string_equal(func_name, string_from_chars("sort_desc"))) {
+        return eval_from_json(eval_func_sort_desc(e, node));
+    } else if (string_equal(func_name, string_from_chars("sort_by"))) {
+        return eval_from_json(eval_func_sort_by(e, node));
+    } else if (string_equal(func_name, string_from_chars("top_k"))) {
+        return eval_from_json(eval_func_top_k(e, node));
+    } else if (string_equal(func_name, string_from_chars("bottom_k"))) {
+        return eval_from_json(eval_func_bottom_k(e, node));
+    } else if (string_equal(func_name, string_from_chars("join_on"))) {
+        return eval_from_iter(eval_func_join_on(e, node));
+    } else if (string_equal(func_name, string_from_chars("left_join_on"))) {
+        return eval_from_iter(eval_func_left_join_on(e, node));
     } else if (string_equal(func_name, string_from_chars("sum"))) {
         return eval_from_json(eval_func_sum(e, node));
     } else if (string_equal(func_name, string_from_chars("product"))) {
@@ -37,6 +61,8 @@ EvalData eval_node_function(Eval *e, ASTNode *node) {
         return eval_from_json(eval_func_join(e, node));
     } else if (string_equal(func_name, string_from_chars("length"))) {
         return eval_from_json(eval_func_length(e, node));
+    } else if (string_equal(func_name, string_from_chars("substring"))) {
+        return eval_from_json(eval_func_substring(e, node));
     } else if (string_equal(func_name, string_from_chars("skip_while"))) {
         return eval_from_iter(eval_func_skip_while(e, node));
     } else if (string_equal(func_name, string_from_chars("take"))) {
@@ -47,6 +73,8 @@ EvalData eval_node_function(Eval *e, ASTNode *node) {
         return eval_from_iter(eval_func_split(e, node));
     } else if (string_equal(func_name, string_from_chars("and_then"))) {
         return eval_from_json(eval_func_and_then(e, node));
+    } else if (string_equal(func_name, string_from_chars("range"))) {
+        return eval_from_iter(eval_func_range(e, node));
     }
 
     eval_set_err(e, EVAL_ERR_FUNC_NOT_FOUND(func_name));
@@ -92,7 +120,7 @@ int vs_push_closure_variable(Eval *e, ASTNode *var, Json value) {
         return 1;
         break;
     case AST_TYPE_LIST:
-        if (value.type != JSON_TYPE_LIST) {
+        if (json_get_type(value) != JSON_TYPE_LIST) {
             eval_set_err(e, EVAL_ERR_FUNC_CLOSURE_TUPLE);
             return 0;
         }
@@ -125,7 +153,7 @@ int vs_pop_closure_variable(Eval *e, ASTNode *var, Json value) {
         vs_pop_variable(vs, var->inner.primary.inner.ident);
         return 1;
     case AST_TYPE_LIST:
-        if (value.type != JSON_TYPE_LIST) {
+        if (json_get_type(value) != JSON_TYPE_LIST) {
             eval_set_err(e, EVAL_ERR_FUNC_CLOSURE_TUPLE);
             return 0;
         }
@@ -151,6 +179,16 @@ int vs_pop_closure_variable(Eval *e, ASTNode *var, Json value) {
 static EvalData func_eval_caller(Eval *e, ASTNode *function_node, struct function_data func) {
     EvalData err = eval_from_json(json_invalid());
 
+    // Free functions like `range(10)` have no caller, and every other function needs one
+    bool is_free = function_node->inner.function.is_free;
+    if (is_free != (func.caller_type == JSON_TYPE_NO_CALLER)) {
+        eval_set_err(e, is_free ? EVAL_ERR_FUNC_MISSING_CALLER : EVAL_ERR_FUNC_UNEXPECTED_CALLER);
+        return err;
+    }
+    if (is_free) {
+        return eval_from_json(json_null());
+    }
+
     EvalData caller = eval_node(e, function_node->inner.function.callee);
 
     if (func.caller_type != JSON_TYPE_ITERATOR && func.caller_type != JSON_TYPE_ANY) {
@@ -166,13 +204,9 @@ static EvalData func_eval_caller(Eval *e, ASTNode *function_node, struct functio
             if (json_list_length(jcaller) != 0) {
                 EXPECT_TYPE(
                     e,
-                    jcaller.list_inner_type,
+                    json_list_get_inner_type(jcaller),
                     list_inner_type,
-                    EVAL_ERR_FUNC_WRONG_CALLER(
-                        json_type((Json) {.type = JSON_TYPE_LIST,
-                                          .list_inner_type = list_inner_type}),
-                        json_type(jcaller)
-                    )
+                    EVAL_ERR_FUNC_WRONG_CALLER(json_list_type(list_inner_type), json_type(jcaller))
                 );
                 if (eval_has_err(e)) {
                     json_free(jcaller);
@@ -182,7 +216,7 @@ static EvalData func_eval_caller(Eval *e, ASTNode *function_node, struct functio
         } else {
             EXPECT_TYPE(
                 e,
-                jcaller.type,
+                json_get_type(jcaller),
                 func.caller_type,
                 EVAL_ERR_FUNC_WRONG_CALLER(JSON_TYPE(func.caller_type), json_type(jcaller))
             );
@@ -254,7 +288,7 @@ static void func_eval_params(
             if (func_data.parameter_types[i] != JSON_TYPE_ANY) {
                 EXPECT_TYPE(
                     e,
-                    j.type,
+                    json_get_type(j),
                     func_data.parameter_types[i],
                     EVAL_ERR_FUNC_WRONG_ARGS(JSON_TYPE(func_data.parameter_types[i]), json_type(j))
                 );
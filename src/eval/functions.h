@@ -7,6 +7,7 @@
 // Don't use this with a T of any, instead just use the normal JSON_TYPE_LIST value
 #define JSON_TYPE_LIST_T(v) (JSON_TYPE_LIST + v)
 #define JSON_TYPE_ITERATOR (-1)
+#define JSON_TYPE_NO_CALLER (-2)
 #define JSON_TYPE_CLOSURE (-10)
 #define JSON_TYPE_CLOSURE_WITH_PARAMS(v) (JSON_TYPE_CLOSURE - (v))
 
@@ -24,6 +25,7 @@
 /// In addition to all the normal json types, there is also the following json types you can use:
 /// - JSON_TYPE_ANY
 /// - JSON_TYPE_ITERATOR
+/// - JSON_TYPE_NO_CALLER                (only as a caller type, for free functions like `range()`)
 /// - JSON_TYPE_LIST_T                   (list that must be a specific type)
 /// - JSON_TYPE_CLOSURE                  (closure with no parameters) -> ||
 /// - JSON_TYPE_CLOSURE_WITH_PARAMS(N)   (closure with N parameters)  -> |p1, p2, ..., pN|
@@ -3,6 +3,7 @@
 #include "src/eval/private.h"
 #include "src/json.h"
 #include "src/parser.h"
+#include "src/strings.h"
 #include "src/utils.h"
 #include "src/vector.h"
 #include <assert.h>
@@ -17,9 +18,21 @@ static EvalData eval_node_grouping(Eval *e, ASTNode *node);
 static EvalData eval_node_list(Eval *e, ASTNode *node);
 static EvalData eval_node_json(Eval *e, ASTNode *node);
 static EvalData eval_node_access(Eval *e, ASTNode *node);
+static EvalData eval_node_unprofiled(Eval *e, ASTNode *node);
 // static EvalData eval_node_closure(Eval *e, ASTNode *node);
 
 EvalData eval_node(Eval *e, ASTNode *node) {
+    if (e->profile == NULL || node == NULL) {
+        return eval_node_unprofiled(e, node);
+    }
+
+    profile_enter(e->profile, node, true);
+    EvalData d = eval_node_unprofiled(e, node);
+    profile_exit(e->profile);
+    return d;
+}
+
+static EvalData eval_node_unprofiled(Eval *e, ASTNode *node) {
     if (node == NULL) {
         return eval_from_json(json_copy(e->input));
     }
@@ -67,21 +80,42 @@ static EvalData eval_node_access(Eval *e, ASTNode *node) {
     Json res = json_null();
 
     Json free_list[] = {inner, accessor};
-    switch (inner.type) {
+    switch (json_get_type(inner)) {
     case JSON_TYPE_LIST:
-        EXPECT_TYPE(e, accessor.type, JSON_TYPE_NUMBER, EVAL_ERR_LIST_ACCESS(json_type(accessor)));
+        EXPECT_TYPE(
+            e, json_get_type(accessor), JSON_TYPE_NUMBER, EVAL_ERR_LIST_ACCESS(json_type(accessor))
+        );
         BUBBLE_ERROR(e, free_list);
 
         res = json_copy(json_list_get(inner, (uint)json_get_number(accessor)));
         break;
     case JSON_TYPE_OBJECT:
-        EXPECT_TYPE(e, accessor.type, JSON_TYPE_STRING, EVAL_ERR_JSON_ACCESS(json_type(accessor)));
+        EXPECT_TYPE(
+            e, json_get_type(accessor), JSON_TYPE_STRING, EVAL_ERR_JSON_ACCESS(json_type(accessor))
+        );
         BUBBLE_ERROR(e, free_list);
 
         res = json_copy(json_object_get(inner, accessor));
         break;
+    case JSON_TYPE_STRING:
+        EXPECT_TYPE(
+            e,
+            json_get_type(accessor),
+            JSON_TYPE_NUMBER,
+            EVAL_ERR_STRING_ACCESS(json_type(accessor))
+        );
+        BUBBLE_ERROR(e, free_list);
+
+        // Strings are indexed by codepoint, past the end there is nothing
+        double index = json_get_number(accessor);
+        if (index >= 0 && index < json_string_codepoints(inner)) {
+            res = json_string_slice(inner, index, index + 1);
+        }
+        break;
     default:
-        EXPECT_TYPE(e, inner.type, JSON_TYPE_LIST, EVAL_ERR_INNER_ACCESS(json_type(inner)));
+        EXPECT_TYPE(
+            e, json_get_type(inner), JSON_TYPE_LIST, EVAL_ERR_INNER_ACCESS(json_type(inner))
+        );
         BUBBLE_ERROR(e, free_list);
     }
 
@@ -103,7 +137,10 @@ static EvalData eval_node_json(Eval *e, ASTNode *node) {
         if (field->type == AST_TYPE_SPREAD) {
             Json inner_obj = eval_to_json(e, eval_node(e, field->inner.spread));
             EXPECT_TYPE(
-                e, inner_obj.type, JSON_TYPE_OBJECT, EVAL_ERR_SPREAD_JSON(json_type(inner_obj))
+                e,
+                json_get_type(inner_obj),
+                JSON_TYPE_OBJECT,
+                EVAL_ERR_SPREAD_JSON(json_type(inner_obj))
             );
             BUBBLE_ERROR(e, (Json[]) {inner_obj});
 
@@ -123,7 +160,9 @@ static EvalData eval_node_json(Eval *e, ASTNode *node) {
 
         Json key = eval_to_json(e, eval_node(e, field->inner.json_field.key));
         Json value = eval_to_json(e, eval_node(e, field->inner.json_field.value));
-        EXPECT_TYPE(e, key.type, JSON_TYPE_STRING, EVAL_ERR_JSON_KEY_STRING(json_type(key)));
+        EXPECT_TYPE(
+            e, json_get_type(key), JSON_TYPE_STRING, EVAL_ERR_JSON_KEY_STRING(json_type(key))
+        );
         BUBBLE_ERROR(e, (Json[]) {obj, key, value});
 
         json_object_set(obj, key, value);
@@ -143,7 +182,10 @@ static EvalData eval_node_list(Eval *e, ASTNode *node) {
         if (elems.data[i]->type == AST_TYPE_SPREAD) {
             Json inner_list = eval_to_json(e, eval_node(e, elems.data[i]->inner.spread));
             EXPECT_TYPE(
-                e, inner_list.type, JSON_TYPE_LIST, EVAL_ERR_SPREAD_LIST(json_type(inner_list))
+                e,
+                json_get_type(inner_list),
+                JSON_TYPE_LIST,
+                EVAL_ERR_SPREAD_LIST(json_type(inner_list))
             );
             BUBBLE_ERROR(e, (Json[]) {inner_list});
 
@@ -180,8 +222,15 @@ static EvalData eval_node_primary(Eval *e, ASTNode *node) {
     switch (node->inner.primary.type) {
     case TOKEN_IDENT:
         return eval_from_json(vs_get_variable(e, node->inner.primary.inner.ident));
-    case TOKEN_STRING:
-        return eval_from_json(json_string_from(node->inner.primary.inner.string));
+    case TOKEN_STRING: {
+        String string = node->inner.primary.inner.string;
+        // Strings with escapes were decoded into a buffer owned by the AST, which is freed before
+        // the result is, so the result needs its own copy.
+        if (string.capacity != 0) {
+            string = string_from_str_alloc(string.data, string.length);
+        }
+        return eval_from_json(json_string_from(string));
+    }
     case TOKEN_NUMBER:
         return eval_from_json(json_number(node->inner.primary.inner.number));
     default:
@@ -197,14 +246,14 @@ static EvalData eval_node_unary(Eval *e, ASTNode *node) {
 
     switch (node->inner.unary.operator) {
     case TOKEN_MINUS:
-        EXPECT_TYPE(e, j.type, JSON_TYPE_NUMBER, EVAL_ERR_UNARY_MINUS(json_type(j)));
+        EXPECT_TYPE(e, json_get_type(j), JSON_TYPE_NUMBER, EVAL_ERR_UNARY_MINUS(json_type(j)));
         BUBBLE_ERROR(e, (Json[]) {j});
 
         j = json_number(-json_get_number(j));
 
         break;
     case TOKEN_BANG:
-        EXPECT_TYPE(e, j.type, JSON_TYPE_BOOL, EVAL_ERR_UNARY_NOT(json_type(j)));
+        EXPECT_TYPE(e, json_get_type(j), JSON_TYPE_BOOL, EVAL_ERR_UNARY_NOT(json_type(j)));
         BUBBLE_ERROR(e, (Json[]) {j});
 
         j = json_boolean(!json_get_bool(j));
@@ -226,7 +275,7 @@ static EvalData eval_node_unary(Eval *e, ASTNode *node) {
         e->range = node->inner.binary.lhs->range;                                                  \
         EXPECT_TYPE(                                                                               \
             e,                                                                                     \
-            lhs.type,                                                                              \
+            json_get_type(lhs),                                                                    \
             _EXPECTED_TYPE,                                                                        \
             EVAL_ERR_BINARY_OP(_OP_NAME, JSON_TYPE(_EXPECTED_TYPE), json_type(lhs))                \
         );                                                                                         \
@@ -235,7 +284,7 @@ static EvalData eval_node_unary(Eval *e, ASTNode *node) {
         e->range = node->inner.binary.rhs->range;                                                  \
         EXPECT_TYPE(                                                                               \
             e,                                                                                     \
-            rhs.type,                                                                              \
+            json_get_type(rhs),                                                                    \
             _EXPECTED_TYPE,                                                                        \
             EVAL_ERR_BINARY_OP(_OP_NAME, JSON_TYPE(_EXPECTED_TYPE), json_type(rhs))                \
         );                                                                                         \
@@ -255,13 +304,40 @@ EVAL_BINARY_OP(eval_binary_lt_equal, JSON_TYPE_NUMBER, "<=", json_boolean(json_g
 EVAL_BINARY_OP(eval_binary_gt_equal, JSON_TYPE_NUMBER, ">=", json_boolean(json_get_number(lhs) >= json_get_number(rhs)));
 EVAL_BINARY_OP(eval_binary_gt, JSON_TYPE_NUMBER, ">", json_boolean(json_get_number(lhs) > json_get_number(rhs)));
 EVAL_BINARY_OP(eval_binary_lt, JSON_TYPE_NUMBER, "<", json_boolean(json_get_number(lhs) < json_get_number(rhs)));
-EVAL_BINARY_OP(eval_binary_add, JSON_TYPE_NUMBER, "+", json_number(json_get_number(lhs) + json_get_number(rhs)));
 EVAL_BINARY_OP(eval_binary_sub, JSON_TYPE_NUMBER, "-", json_number(json_get_number(lhs) - json_get_number(rhs)));
 EVAL_BINARY_OP(eval_binary_times, JSON_TYPE_NUMBER, "*", json_number(json_get_number(lhs) * json_get_number(rhs)));
 EVAL_BINARY_OP(eval_binary_div, JSON_TYPE_NUMBER, "/", json_number(json_get_number(lhs) / json_get_number(rhs)));
 EVAL_BINARY_OP(eval_binary_mod, JSON_TYPE_NUMBER, "%%", json_number(fmod(json_get_number(lhs), json_get_number(rhs))));
 // clang-format on
 
+/// `+` adds two numbers, or concatenates two strings.
+static EvalData eval_binary_add(Eval *e, ASTNode *node) {
+    assert(node->type == AST_TYPE_BINARY);
+
+    Json lhs = eval_to_json(e, eval_node(e, node->inner.binary.lhs));
+    e->range = node->inner.binary.lhs->range;
+    JsonType type = json_get_type(lhs) == JSON_TYPE_STRING ? JSON_TYPE_STRING : JSON_TYPE_NUMBER;
+    EXPECT_TYPE(
+        e, json_get_type(lhs), type, EVAL_ERR_BINARY_OP("+", JSON_TYPE(type), json_type(lhs))
+    );
+    BUBBLE_ERROR(e, (Json[]) {lhs});
+    Json rhs = eval_to_json(e, eval_node(e, node->inner.binary.rhs));
+    e->range = node->inner.binary.rhs->range;
+    EXPECT_TYPE(
+        e, json_get_type(rhs), type, EVAL_ERR_BINARY_OP("+", JSON_TYPE(type), json_type(rhs))
+    );
+    BUBBLE_ERROR(e, (Json[]) {lhs, rhs});
+
+    e->range = node->range;
+    if (type == JSON_TYPE_STRING) {
+        return eval_from_json(json_string_add(lhs, rhs));
+    }
+    Json ret = json_number(json_get_number(lhs) + json_get_number(rhs));
+    json_free(lhs);
+    json_free(rhs);
+    return eval_from_json(ret);
+}
+
 static EvalData eval_node_binary(Eval *e, ASTNode *node) {
     assert(node->type == AST_TYPE_BINARY);
 
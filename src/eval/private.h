@@ -1,6 +1,7 @@
 #ifndef _EVAL_PRIVATE_H
 #define _EVAL_PRIVATE_H
 #include "src/errors.h"
+#include "src/eval.h"
 #include "src/json.h"
 #include "src/json_iter.h"
 #include "src/parser.h"
@@ -10,7 +11,7 @@
         json_free(FREE[_i]);                                                                       \
     }
 
-#define JSON_TYPE(J) json_type((Json) {.type = J})
+#define JSON_TYPE(J) json_type_name(J)
 
 // will clean up everything in the free list and return from the function.
 //
@@ -78,6 +79,9 @@ typedef struct {
     /// all our variables: we would push v for the map, then push another v for
     /// the filter.
     VariableStack vs;
+
+    /// Where the time spent evaluating each node is recorded, NULL when not profiling.
+    Profile *profile;
 } Eval;
 
 /// If `d` is already json, do nothing.
@@ -96,6 +100,10 @@ EvalData eval_from_iter(JsonIterator i);
 void free_eval_data(EvalData *e);
 
 EvalData eval_node(Eval *e, ASTNode *node);
+
+void profile_enter(Profile *p, ASTNode *node, bool call);
+void profile_exit(Profile *p);
+void profile_finish(Profile *p);
 EvalData eval_node_function(Eval *e, ASTNode *node);
 
 #endif // _EVAL_PRIVATE_H
@@ -0,0 +1,278 @@
+#include "src/alloc.h"
+#include "src/eval.h"
+#include "src/eval/private.h"
+#include "src/parser.h"
+#include "src/strings.h"
+#include "src/vector.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    ASTNode *node;
+
+    /// Copied out of the node, the ast is freed before the profile is formatted
+    Range range;
+
+    size_t calls;
+    uint64_t total_ns;
+    uint64_t self_ns;
+    size_t allocations;
+} ProfileEntry;
+
+/// A node that is being evaluated right now.
+typedef struct {
+    ProfileEntry *entry;
+    uint64_t start_ns;
+    size_t start_allocations;
+
+    /// How much of the time since `start` was spent in nodes inside of this one
+    uint64_t child_ns;
+} ProfileFrame;
+
+struct Profile {
+    /// Open addressed by the address of the node, there are always free slots.
+    ProfileEntry *entries;
+    size_t capacity;
+
+    Vec(ProfileFrame) frames;
+
+    uint64_t start_ns;
+    uint64_t total_ns;
+    size_t start_allocations;
+    size_t total_allocations;
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static size_t count_nodes(ASTNode *node);
+
+static size_t count_node_list(Vec_ASTNode nodes) {
+    size_t count = 0;
+    for (size_t i = 0; i < nodes.length; i++) {
+        count += count_nodes(nodes.data[i]);
+    }
+    return count;
+}
+
+static size_t count_nodes(ASTNode *node) {
+    if (node == NULL) {
+        return 0;
+    }
+
+    switch (node->type) {
+    case AST_TYPE_UNARY:
+        return 1 + count_nodes(node->inner.unary.rhs);
+    case AST_TYPE_BINARY:
+        return 1 + count_nodes(node->inner.binary.lhs) + count_nodes(node->inner.binary.rhs);
+    case AST_TYPE_FUNCTION:
+        return 1 + count_nodes(node->inner.function.callee)
+               + count_node_list(node->inner.function.args);
+    case AST_TYPE_CLOSURE:
+        return 1 + count_node_list(node->inner.closure.args)
+               + count_nodes(node->inner.closure.body);
+    case AST_TYPE_ACCESS:
+        return 1 + count_nodes(node->inner.access.inner)
+               + count_nodes(node->inner.access.accessor);
+    case AST_TYPE_LIST:
+        return 1 + count_node_list(node->inner.list);
+    case AST_TYPE_JSON_FIELD:
+        return 1 + count_nodes(node->inner.json_field.key)
+               + count_nodes(node->inner.json_field.value);
+    case AST_TYPE_JSON_OBJECT:
+        return 1 + count_node_list(node->inner.json_object);
+    case AST_TYPE_GROUPING:
+        return 1 + count_nodes(node->inner.grouping);
+    case AST_TYPE_SPREAD:
+        return 1 + count_nodes(node->inner.spread);
+    case AST_TYPE_PRIMARY:
+    case AST_TYPE_FALSE:
+    case AST_TYPE_TRUE:
+    case AST_TYPE_NULL:
+        return 1;
+    }
+    return 1;
+}
+
+/// The entry of `node`, a new one is made if it has none yet.
+static ProfileEntry *profile_entry(Profile *p, ASTNode *node) {
+    size_t i = ((uintptr_t)node >> 4) & (p->capacity - 1);
+    while (p->entries[i].node != NULL && p->entries[i].node != node) {
+        i = (i + 1) & (p->capacity - 1);
+    }
+
+    ProfileEntry *entry = &p->entries[i];
+    if (entry->node == NULL) {
+        entry->node = node;
+        entry->range = node->range;
+    }
+    return entry;
+}
+
+/// Start profiling the evaluation of `node`, which is what the query is made of.
+Profile *profile_new(ASTNode *node) {
+    Profile *p = jrq_calloc(1, sizeof(*p));
+
+    // At most half full, so that probing stays short
+    size_t capacity = 16;
+    while (capacity < count_nodes(node) * 2) {
+        capacity *= 2;
+    }
+    p->capacity = capacity;
+    p->entries = jrq_calloc(capacity, sizeof(*p->entries));
+
+    p->start_ns = now_ns();
+    p->start_allocations = jrq_allocations;
+    return p;
+}
+
+/// Stops the clock on the whole query.
+void profile_finish(Profile *p) {
+    p->total_ns = now_ns() - p->start_ns;
+    p->total_allocations = jrq_allocations - p->start_allocations;
+}
+
+/// Start timing `node`. `call` is false when `node` is being resumed rather than evaluated, like
+/// when the iterator it evaluated to is collected.
+void profile_enter(Profile *p, ASTNode *node, bool call) {
+    ProfileEntry *entry = profile_entry(p, node);
+    if (call) {
+        entry->calls++;
+    }
+
+    vec_append(
+        p->frames,
+        (ProfileFrame) {
+            .entry = entry,
+            .start_ns = now_ns(),
+            .start_allocations = jrq_allocations,
+        }
+    );
+}
+
+/// Stop timing the node that was entered last.
+void profile_exit(Profile *p) {
+    ProfileFrame frame = vec_pop(p->frames);
+    uint64_t elapsed = now_ns() - frame.start_ns;
+
+    frame.entry->total_ns += elapsed;
+    frame.entry->self_ns += elapsed - frame.child_ns;
+    frame.entry->allocations += jrq_allocations - frame.start_allocations;
+
+    if (p->frames.length > 0) {
+        p->frames.data[p->frames.length - 1].child_ns += elapsed;
+    }
+}
+
+static int compare_entries(const void *a, const void *b) {
+    const ProfileEntry *x = *(ProfileEntry **)a;
+    const ProfileEntry *y = *(ProfileEntry **)b;
+
+    if (x->range.start.line != y->range.start.line) {
+        return x->range.start.line < y->range.start.line ? -1 : 1;
+    }
+    // The slowest nodes of a line are shown first
+    if (x->total_ns != y->total_ns) {
+        return x->total_ns > y->total_ns ? -1 : 1;
+    }
+    return x->range.start.col < y->range.start.col ? -1 : x->range.start.col > y->range.start.col;
+}
+
+static double percent(uint64_t part, uint64_t whole) {
+    return whole == 0 ? 0 : (double)part * 100 / (double)whole;
+}
+
+/// The line `line` (starting at 1) of `code`, without its newline.
+static String source_line(char *code, uint line) {
+    for (uint l = 1; l < line && *code != '\0'; l++) {
+        char *newline = strchr(code, '\n');
+        code = newline != NULL ? newline + 1 : code + strlen(code);
+    }
+    return string_from_str(code, (uint)strcspn(code, "\n"));
+}
+
+#define PROFILE_COLUMNS "%7s %7s %10s %9s %9s  "
+
+/// Annotates `code` with where the time and allocations of evaluating it went.
+///
+/// Every line of the query is followed by each node that starts on it, with the node underlined
+/// and the time that was spent in it and in the nodes inside it (`total`), the part of that which
+/// was spent in the node itself (`self`), how often it was evaluated and how many allocations were
+/// made while evaluating it.
+char *profile_format(Profile *p, char *code) {
+    Vec(ProfileEntry *) entries = {0};
+    for (size_t i = 0; i < p->capacity; i++) {
+        // Nodes that were never evaluated and nodes made up by the parser aren't shown
+        ProfileEntry *entry = &p->entries[i];
+        if (entry->node != NULL && entry->calls > 0 && entry->range.start.line != 0) {
+            vec_append(entries, entry);
+        }
+    }
+    qsort(entries.data, entries.length, sizeof(*entries.data), compare_entries);
+
+    String out = string_from_chars_alloc("");
+    string_printf(
+        &out,
+        "Profile: %.3fms, %zu allocations\n%7s %7s %10s %9s %9s\n",
+        (double)p->total_ns / 1e6,
+        p->total_allocations,
+        "total",
+        "self",
+        "time",
+        "calls",
+        "allocs"
+    );
+
+    uint line = 0;
+    for (size_t i = 0; i < entries.length; i++) {
+        ProfileEntry *entry = entries.data[i];
+        String source = source_line(code, entry->range.start.line);
+
+        if (entry->range.start.line != line) {
+            line = entry->range.start.line;
+            string_printf(
+                &out, PROFILE_COLUMNS "%.*s\n", "", "", "", "", "", source.length, source.data
+            );
+        }
+
+        // Nodes that go on past the end of the line are underlined up to the end of the line
+        uint start = entry->range.start.col;
+        uint end = entry->range.end.line == line ? entry->range.end.col : source.length;
+        if (end < start) {
+            end = start;
+        }
+
+        string_printf(
+            &out,
+            "%6.1f%% %6.1f%% %8.3fms %9zu %9zu  %*s^",
+            percent(entry->total_ns, p->total_ns),
+            percent(entry->self_ns, p->total_ns),
+            (double)entry->total_ns / 1e6,
+            entry->calls,
+            entry->allocations,
+            (int)start - 1,
+            ""
+        );
+        for (uint col = start; col < end; col++) {
+            string_append(&out, string_from_chars("~"));
+        }
+        string_append(&out, string_from_chars("\n"));
+    }
+
+    jrq_free(entries.data);
+    return out.data;
+}
+
+void profile_free(Profile *p) {
+    if (p == NULL) {
+        return;
+    }
+    jrq_free(p->entries);
+    jrq_free(p->frames.data);
+    jrq_free(p);
+}
@@ -0,0 +1,312 @@
+#include "src/eval.h"
+#include "src/parser.h"
+#include "src/projection.h"
+#include "src/strings.h"
+#include "src/utils.h"
+#include "src/vector.h"
+#include <assert.h>
+#include <stdlib.h>
+
+/// The parts of the input (and of values created by the query) that a value can be.
+///
+/// An empty list means that the value is not part of the input, or that the part of the input it
+/// comes from is already entirely needed.
+typedef Vec(Projection *) Aliases;
+
+typedef struct {
+    String name;
+    Aliases aliases;
+} AnalysisVariable;
+
+/// Says that the values `depth` levels of elements deep into the list `list` are each of `to`.
+///
+/// The result of `.map(|v| v.foo)` is a list that is created by the query, but its elements are
+/// `foo` fields of the input. Anything that is read from those elements is read from `v.foo`.
+typedef struct {
+    Projection *list;
+    int depth;
+    Aliases to;
+} AnalysisLink;
+
+typedef struct {
+    /// The projection of the input json
+    Projection *root;
+
+    /// The variables of the closures that are being analyzed, see `Eval.vs` for how this works.
+    Vec(AnalysisVariable) vs;
+
+    /// Projections of values that are created by the query, they are not part of the input.
+    Vec(Projection *) synthetic;
+
+    Vec(AnalysisLink) links;
+} Analysis;
+
+static Aliases analyze(Analysis *a, ASTNode *node);
+
+static Aliases aliases_of(Projection *p) {
+    Aliases al = {0};
+    vec_append(al, p);
+    return al;
+}
+
+static Aliases aliases_copy(Aliases al) {
+    Aliases copy = {0};
+    for (size_t i = 0; i < al.length; i++) {
+        vec_append(copy, al.data[i]);
+    }
+    return copy;
+}
+
+/// The elements of each of `al`.
+static Aliases aliases_elements(Aliases al) {
+    Aliases elements = {0};
+    for (size_t i = 0; i < al.length; i++) {
+        vec_append(elements, projection_elements(al.data[i]));
+    }
+    return elements;
+}
+
+/// Mark everything `al` can be as entirely needed, consumes `al`.
+static void use_whole(Aliases al) {
+    for (size_t i = 0; i < al.length; i++) {
+        al.data[i]->whole = true;
+    }
+    jrq_free(al.data);
+}
+
+static Projection *synthetic(Analysis *a) {
+    Projection *p = projection_new();
+    vec_append(a->synthetic, p);
+    return p;
+}
+
+/// Push the variables of a closure parameter, returns the amount of variables pushed.
+static int bind_param(Analysis *a, ASTNode *param, Aliases al) {
+    if (param->type == AST_TYPE_PRIMARY) {
+        vec_append(a->vs, (AnalysisVariable) {param->inner.primary.inner.ident, aliases_copy(al)});
+        return 1;
+    }
+
+    // Destructuring `|[k, v]|`, both `k` and `v` are elements of the value
+    Aliases elements = aliases_elements(al);
+    int pushed = 0;
+    for (size_t i = 0; i < param->inner.list.length; i++) {
+        pushed += bind_param(a, param->inner.list.data[i], elements);
+    }
+    jrq_free(elements.data);
+    return pushed;
+}
+
+/// Analyze the body of `closure` with its parameter being `param`.
+static Aliases analyze_closure(Analysis *a, ASTNode *closure, Aliases param) {
+    int pushed = 0;
+    if (closure->inner.closure.args.length > 0) {
+        pushed = bind_param(a, closure->inner.closure.args.data[0], param);
+    }
+
+    Aliases body = analyze(a, closure->inner.closure.body);
+
+    for (int i = 0; i < pushed; i++) {
+        jrq_free(vec_pop(a->vs).aliases.data);
+    }
+    return body;
+}
+
+static Aliases analyze_variable(Analysis *a, String name) {
+    for (size_t i = a->vs.length; i-- > 0;) {
+        if (string_equal(a->vs.data[i].name, name)) {
+            return aliases_copy(a->vs.data[i].aliases);
+        }
+    }
+    return (Aliases) {0};
+}
+
+static Aliases analyze_access(Analysis *a, ASTNode *node) {
+    Aliases inner = analyze(a, node->inner.access.inner);
+    ASTNode *accessor = node->inner.access.accessor;
+
+    if (accessor->type == AST_TYPE_PRIMARY && accessor->inner.primary.type == TOKEN_STRING) {
+        for (size_t i = 0; i < inner.length; i++) {
+            inner.data[i] = projection_field(inner.data[i], accessor->inner.primary.inner.string);
+        }
+        return inner;
+    }
+
+    if (accessor->type == AST_TYPE_PRIMARY && accessor->inner.primary.type == TOKEN_NUMBER) {
+        Aliases elements = aliases_elements(inner);
+        jrq_free(inner.data);
+        return elements;
+    }
+
+    // Any field could be accessed
+    use_whole(analyze(a, accessor));
+    use_whole(inner);
+    return (Aliases) {0};
+}
+
+static bool is_function(ASTNode *node, char *name, size_t args) {
+    return node->inner.function.args.length == args
+           && string_equal(
+               node->inner.function.function_name.inner.string, string_from_chars(name)
+           );
+}
+
+static bool is_closure_function(ASTNode *node, char *name) {
+    return is_function(node, name, 1)
+           && node->inner.function.args.data[0]->type == AST_TYPE_CLOSURE;
+}
+
+static Aliases analyze_function(Analysis *a, ASTNode *node) {
+    // A free function like `range(10)` has no callee, rather than the input as its callee
+    Aliases callee
+        = node->inner.function.is_free ? (Aliases) {0} : analyze(a, node->inner.function.callee);
+    Vec_ASTNode args = node->inner.function.args;
+
+    if (is_closure_function(node, "map")) {
+        Aliases elements = aliases_elements(callee);
+        Aliases body = analyze_closure(a, args.data[0], elements);
+        jrq_free(elements.data);
+        jrq_free(callee.data);
+
+        Projection *result = synthetic(a);
+        vec_append(a->links, (AnalysisLink) {result, 1, body});
+        return aliases_of(result);
+    }
+
+    if (is_closure_function(node, "filter") || is_closure_function(node, "skip_while")
+        || is_closure_function(node, "unique_by")) {
+        Aliases elements = aliases_elements(callee);
+        use_whole(analyze_closure(a, args.data[0], elements));
+        jrq_free(elements.data);
+
+        // The elements that are left are the same as the elements of the caller
+        return callee;
+    }
+
+    if (is_closure_function(node, "and_then")) {
+        Aliases body = analyze_closure(a, args.data[0], callee);
+        jrq_free(callee.data);
+        return body;
+    }
+
+    if (is_function(node, "iter", 0) || is_function(node, "collect", 0)) {
+        return callee;
+    }
+
+    if (is_function(node, "take", 1) || is_function(node, "skip", 1)) {
+        use_whole(analyze(a, args.data[0]));
+        return callee;
+    }
+
+    if (is_function(node, "enumerate", 0)) {
+        // Elements become `[index, element]`
+        Aliases elements = aliases_elements(callee);
+        jrq_free(callee.data);
+
+        Projection *result = synthetic(a);
+        vec_append(a->links, (AnalysisLink) {result, 2, elements});
+        return aliases_of(result);
+    }
+
+    // Nothing is known about what this function reads, so it could read everything.
+    use_whole(callee);
+    for (size_t i = 0; i < args.length; i++) {
+        if (args.data[i]->type == AST_TYPE_CLOSURE) {
+            use_whole(analyze_closure(a, args.data[i], (Aliases) {0}));
+        } else {
+            use_whole(analyze(a, args.data[i]));
+        }
+    }
+    return (Aliases) {0};
+}
+
+/// Find what parts of the input `node` can evaluate to, and record what parts are read.
+static Aliases analyze(Analysis *a, ASTNode *node) {
+    if (node == NULL) {
+        return aliases_of(a->root);
+    }
+
+    switch (node->type) {
+    case AST_TYPE_PRIMARY:
+        if (node->inner.primary.type == TOKEN_IDENT) {
+            return analyze_variable(a, node->inner.primary.inner.ident);
+        }
+        return (Aliases) {0};
+    case AST_TYPE_GROUPING:
+        return analyze(a, node->inner.grouping);
+    case AST_TYPE_ACCESS:
+        return analyze_access(a, node);
+    case AST_TYPE_FUNCTION:
+        return analyze_function(a, node);
+    case AST_TYPE_UNARY:
+        use_whole(analyze(a, node->inner.unary.rhs));
+        return (Aliases) {0};
+    case AST_TYPE_BINARY:
+        use_whole(analyze(a, node->inner.binary.lhs));
+        use_whole(analyze(a, node->inner.binary.rhs));
+        return (Aliases) {0};
+    case AST_TYPE_LIST:
+    case AST_TYPE_JSON_OBJECT: {
+        Vec_ASTNode items
+            = node->type == AST_TYPE_LIST ? node->inner.list : node->inner.json_object;
+        for (size_t i = 0; i < items.length; i++) {
+            use_whole(analyze(a, items.data[i]));
+        }
+        return (Aliases) {0};
+    }
+    case AST_TYPE_JSON_FIELD:
+        use_whole(analyze(a, node->inner.json_field.key));
+        use_whole(analyze(a, node->inner.json_field.value));
+        return (Aliases) {0};
+    case AST_TYPE_SPREAD:
+        use_whole(analyze(a, node->inner.spread));
+        return (Aliases) {0};
+    case AST_TYPE_CLOSURE:
+        // Closures are only analyzed as arguments of functions
+        use_whole(analyze_closure(a, node, (Aliases) {0}));
+        return (Aliases) {0};
+    case AST_TYPE_FALSE:
+    case AST_TYPE_TRUE:
+    case AST_TYPE_NULL:
+        return (Aliases) {0};
+    }
+    unreachable("Cannot reach");
+}
+
+/// Find the parts of the input that evaluating `node` can read.
+///
+/// If the returned projection is `whole`, the entire input is needed. The projection borrows the
+/// field names from `node`, so it has to be freed before `node` is.
+Projection *eval_projection(ASTNode *node) {
+    Analysis a = {.root = projection_new()};
+
+    // The result of the query is output, so all of it is needed
+    use_whole(analyze(&a, node));
+
+    // A link can only point to values that were created before it, so going backwards means
+    // everything a value is used for is known before it's added to the values it came from.
+    for (size_t i = a.links.length; i-- > 0;) {
+        AnalysisLink link = a.links.data[i];
+
+        // A list that is needed as a whole needs all of its elements as well
+        Projection *from = link.list;
+        for (int d = 0; d < link.depth && from != NULL && !from->whole; d++) {
+            from = from->elements;
+        }
+
+        for (size_t j = 0; from != NULL && j < link.to.length; j++) {
+            projection_merge(link.to.data[j], from);
+        }
+        jrq_free(link.to.data);
+    }
+
+    for (size_t i = 0; i < a.synthetic.length; i++) {
+        projection_free(a.synthetic.data[i]);
+    }
+
+    jrq_free(a.links.data);
+    jrq_free(a.synthetic.data);
+    jrq_free(a.vs.data);
+
+    return a.root;
+}
@@ -1,4 +1,6 @@
+#include "src/alloc.h"
 #include "src/json.h"
+#include "src/json_serde.h"
 #include "src/strings.h"
 #include "src/utils.h"
 #include "src/vector.h"
@@ -16,23 +18,53 @@ typedef struct RefCnt {
     uint count;
 } RefCnt;
 
+#ifdef JSON_NAN_BOXING
+
+/// The bits of the NaN that every NaN is stored as, before adding `JSON_NUMBER_OFFSET`.
+#define CANONICAL_NAN 0x7ff8000000000000ull
+
+static Json json_tagged(JsonType type, uint64_t payload) {
+    assert(payload <= JSON_PAYLOAD_MASK);
+    return (Json) {.bits = ((uint64_t)type << 48) | payload};
+}
+
+static Json json_from_ref(JsonType type, RefCnt *ref) {
+    return json_tagged(type, (uintptr_t)ref);
+}
+
+static RefCnt *json_ref(Json j) {
+    return (RefCnt *)(uintptr_t)(j.bits & JSON_PAYLOAD_MASK);
+}
+
+#else
+
+static Json json_from_ref(JsonType type, RefCnt *ref) {
+    return (Json) {.type = type, .inner.ptr = ref};
+}
+
+static RefCnt *json_ref(Json j) {
+    return j.inner.ptr;
+}
+
+#endif
+
 uint refcnt_get(Json v) {
-    switch (v.type) {
+    switch (json_get_type(v)) {
     case JSON_TYPE_OBJECT:
     case JSON_TYPE_LIST:
     case JSON_TYPE_STRING:
-        return v.inner.ptr->count;
+        return json_ref(v)->count;
     default:
         return 1;
     }
 }
 
 void refcnt_inc(Json v) {
-    switch (v.type) {
+    switch (json_get_type(v)) {
     case JSON_TYPE_OBJECT:
     case JSON_TYPE_LIST:
     case JSON_TYPE_STRING:
-        v.inner.ptr->count++;
+        json_ref(v)->count++;
         break;
     default:
         break;
@@ -41,52 +73,241 @@ void refcnt_inc(Json v) {
 
 // Returns true if there are no more references and it should be freed.
 bool refcnt_dec(Json v) {
-    switch (v.type) {
+    switch (json_get_type(v)) {
     case JSON_TYPE_OBJECT:
     case JSON_TYPE_LIST:
     case JSON_TYPE_STRING:
-        return --v.inner.ptr->count == 0;
+        return --json_ref(v)->count == 0;
 
     default:
         return false;
     }
 }
 
-#define json_ptr_list(J) ((JsonListRef *)(J).inner.ptr)
-#define json_ptr_object(J) ((JsonObjectRef *)(J).inner.ptr)
-#define json_ptr_string(J) ((JsonStringRef *)(J).inner.ptr)
+#define json_ptr_list(J) ((JsonListRef *)json_ref(J))
+#define json_ptr_object(J) ((JsonObjectRef *)json_ref(J))
+#define json_ptr_string(J) ((JsonStringRef *)json_ref(J))
+
+size_t json_created[JSON_TYPE_LIST + 1] = {0};
+bool json_count_created = false;
+
+/// A freed list, object or string header, waiting to be reused.
+typedef struct PoolItem {
+    struct PoolItem *next;
+} PoolItem;
+
+/// Headers are allocated in slabs of this many bytes, which are aligned to their size so the slab
+/// of a header is found by rounding its address down.
+#define SLAB_BYTES 4096
+
+/// How many free headers a pool can hold before slabs whose headers are all free are given back.
+/// Without a limit the pool keeps everything a large query freed, so the peak that `--stats` and
+/// `--mem-limit` see stays up and later queries walk a free list scattered over all of it.
+#define POOL_HIGH_WATER 1024
+
+/// A block of headers of a single type, at the start of its `SLAB_BYTES` bytes.
+typedef struct Slab {
+    /// Neighbours in the list of slabs of a pool
+    struct Slab *prev;
+    struct Slab *next;
+
+    /// The headers of this slab that are free
+    PoolItem *free;
+    uint32_t free_count;
+    uint32_t capacity;
+
+    /// Whether the slab is in the list of a pool. Slabs with no free headers aren't, and neither
+    /// are the ones of a thread that has released its pools.
+    bool listed;
+} Slab;
+
+/// Where the headers of this slab start.
+#define SLAB_HEADERS_OFFSET ((sizeof(Slab) + 15) & ~(size_t)15)
+
+/// The slabs with free headers of a single type.
+typedef struct {
+    Slab *slabs;
+    size_t free_count;
+} Pool;
+
+/// The pools of each type. Every thread has its own pools, so they don't need to be locked.
+///
+/// A header has to be freed on the thread that created it, or after that thread has called
+/// `json_pool_release`. Its slab then becomes part of the pool of the thread that frees it.
+static _Thread_local Pool pools[JSON_TYPE_LIST + 1];
+
+static void slab_link(Pool *pool, Slab *slab) {
+    slab->prev = NULL;
+    slab->next = pool->slabs;
+    if (pool->slabs != NULL) {
+        pool->slabs->prev = slab;
+    }
+    pool->slabs = slab;
+    slab->listed = true;
+    pool->free_count += slab->free_count;
+}
+
+static void slab_unlink(Pool *pool, Slab *slab) {
+    if (slab->prev != NULL) {
+        slab->prev->next = slab->next;
+    } else {
+        pool->slabs = slab->next;
+    }
+    if (slab->next != NULL) {
+        slab->next->prev = slab->prev;
+    }
+    slab->listed = false;
+    pool->free_count -= slab->free_count;
+}
+
+/// Add a new slab of headers of `size` bytes to `pool`.
+static void pool_refill(Pool *pool, size_t size) {
+    Slab *slab = jrq_aligned_alloc(SLAB_BYTES, SLAB_BYTES);
+    uint32_t capacity = (SLAB_BYTES - SLAB_HEADERS_OFFSET) / size;
+
+    char *headers = (char *)slab + SLAB_HEADERS_OFFSET;
+    for (size_t i = 0; i < capacity; i++) {
+        PoolItem *item = (PoolItem *)(headers + i * size);
+        item->next = i + 1 < capacity ? (PoolItem *)(headers + (i + 1) * size) : NULL;
+    }
+    *slab = (Slab) {.free = (PoolItem *)headers, .free_count = capacity, .capacity = capacity};
+    slab_link(pool, slab);
+}
+
+/// Let go of the pools of this thread. A thread that creates json has to call this before it
+/// exits, so that the json it leaves behind can be freed by other threads.
+///
+/// Slabs with only free headers are given back right away. The others are adopted by the pool of
+/// whichever thread frees one of their headers next.
+void json_pool_release(void) {
+    for (JsonType type = 0; type <= JSON_TYPE_LIST; type++) {
+        Pool *pool = &pools[type];
+        while (pool->slabs != NULL) {
+            Slab *slab = pool->slabs;
+            slab_unlink(pool, slab);
+            if (slab->free_count == slab->capacity) {
+                jrq_free(slab);
+            }
+        }
+    }
+}
+
+/// Create the header of a list, object or string, `size` has to be the same for every `type`.
+RefCnt *refcnt_init(size_t size, JsonType type) {
+    // Worker threads of the parallel deserializer create json as well
+    if (json_count_created) {
+        __atomic_fetch_add(&json_created[type], 1, __ATOMIC_RELAXED);
+    }
+
+    Pool *pool = &pools[type];
+    if (pool->slabs == NULL) {
+        pool_refill(pool, size);
+    }
+    Slab *slab = pool->slabs;
+    RefCnt *r = (RefCnt *)slab->free;
+    slab->free = slab->free->next;
+    slab->free_count--;
+    pool->free_count--;
+    if (slab->free == NULL) {
+        slab_unlink(pool, slab);
+    }
 
-RefCnt *refcnt_init(size_t size) {
-    RefCnt *r = malloc(size);
     memset(r, 0, size);
     r->count = 1;
     return r;
 }
 
+/// Return a header created by `refcnt_init` to its slab.
+static void refcnt_free(RefCnt *r, JsonType type) {
+    Pool *pool = &pools[type];
+    Slab *slab = (Slab *)((uintptr_t)r & ~(uintptr_t)(SLAB_BYTES - 1));
+
+    PoolItem *item = (PoolItem *)r;
+    item->next = slab->free;
+    slab->free = item;
+    slab->free_count++;
+    if (!slab->listed) {
+        slab_link(pool, slab);
+    } else {
+        pool->free_count++;
+    }
+
+    if (slab->free_count == slab->capacity && pool->free_count > POOL_HIGH_WATER) {
+        slab_unlink(pool, slab);
+        jrq_free(slab);
+    }
+}
+
 typedef struct {
     RefCnt ref;
 
     JsonList d;
+
+    /// The type of all elements, `JSON_TYPE_ANY` if they differ or `JSON_TYPE_INVALID` if there
+    /// are none. Kept up to date by `json_list_append`.
+    JsonType inner_type;
+
+    /// If the list hasn't been parsed yet, this points to its opening `[` in the source text and
+    /// `d` is empty. The list is parsed the first time its elements are accessed.
+    char *lazy;
 } JsonListRef;
 
 typedef struct {
     RefCnt ref;
 
     JsonObject d;
+
+    /// If the object hasn't been parsed yet, this points to its opening `{` in the source text.
+    ///
+    /// While the object is lazy, `d` only caches the fields that were found by `json_object_get`.
+    /// The whole object is parsed the first time anything else accesses it.
+    char *lazy;
 } JsonObjectRef;
 
+/// Strings up to this long are stored in their header, instead of in a buffer of their own.
+#define SMALL_STRING_LENGTH 15
+
+/// What is known about the characters of a string, see `JsonStringRef.ascii`.
+enum {
+    ASCII_UNKNOWN,
+    ASCII_ONLY,
+    ASCII_NOT_ONLY,
+};
+
 typedef struct JsonStringRef {
     RefCnt ref;
 
-    /// If the string is not a substring, this will be json_null
-    ///
-    /// When the string is a substring, this will point to the original string that this string is a
-    /// substring of.
-    Json borrowed_string;
+    /// The string can be serialized as is without escaping anything, because it is a slice of json
+    /// source text that had no escape sequences or it's small and has nothing that needs escaping.
+    bool plain;
+
+    /// The string is stored in `small`, and `d` points to it.
+    bool is_small;
+
+    /// Whether the string is only made of ascii, one of `ASCII_*`. It's found out the first time
+    /// the codepoints of the string are counted, see `json_string_codepoints`.
+    uint8_t ascii;
+
+    /// Whether `hash` has been computed yet, see `json_string_hash`.
+    bool hashed;
+    uint64_t hash;
+
     String d;
+
+    union {
+        /// If the string is not a substring, this will be json_null
+        ///
+        /// When the string is a substring, this will point to the original string that this
+        /// string is a substring of.
+        Json borrowed_string;
+
+        /// Where small strings are stored, they are never substrings. Includes a NUL at the end.
+        char small[SMALL_STRING_LENGTH + 1];
+    };
 } JsonStringRef;
 
-static char *json_list_type(JsonType type) {
+/// The name of the type of a list whose elements are all of `type`.
+char *json_list_type(JsonType type) {
     switch (type) {
     case JSON_TYPE_INVALID:
         return "list";
@@ -108,13 +329,23 @@ static char *json_list_type(JsonType type) {
 }
 
 char *json_type(Json j) {
-    switch (j.type) {
+    if (json_get_type(j) == JSON_TYPE_LIST) {
+        return json_list_type(json_ptr_list(j)->inner_type);
+    }
+    return json_type_name(json_get_type(j));
+}
+
+/// The name of `type`, which can also be a list of a specific type like `JSON_TYPE_LIST + inner`.
+char *json_type_name(JsonType type) {
+    if (type >= JSON_TYPE_LIST) {
+        return json_list_type(type - JSON_TYPE_LIST);
+    }
+
+    switch (type) {
     case JSON_TYPE_INVALID:
         return "<invalid>";
     case JSON_TYPE_OBJECT:
         return "object";
-    case JSON_TYPE_LIST:
-        return json_list_type(j.list_inner_type);
     case JSON_TYPE_NULL:
         return "<null>";
     case JSON_TYPE_NUMBER:
@@ -128,22 +359,39 @@ char *json_type(Json j) {
     }
 }
 
+/// Compares the lengths first, then the hashes if both strings already have one, and only then
+/// the bytes.
+static bool json_string_equal(Json j1, Json j2) {
+    JsonStringRef *s1 = json_ptr_string(j1);
+    JsonStringRef *s2 = json_ptr_string(j2);
+    if (s1 == s2) {
+        return true;
+    }
+    if (s1->d.length != s2->d.length) {
+        return false;
+    }
+    if (s1->hashed && s2->hashed && s1->hash != s2->hash) {
+        return false;
+    }
+    return string_equal(s1->d, s2->d);
+}
+
 bool json_equal(Json j1, Json j2) {
-    if (j1.type != j2.type) {
+    if (json_get_type(j1) != json_get_type(j2)) {
         return false;
     }
 
     bool result = true;
 
-    switch (j1.type) {
+    switch (json_get_type(j1)) {
     case JSON_TYPE_NUMBER:
-        result = fabs(j1.inner.number - j2.inner.number) <= EPSILON;
+        result = fabs(json_get_number(j1) - json_get_number(j2)) <= EPSILON;
         break;
     case JSON_TYPE_STRING:
-        result = string_equal(*json_get_string(j1), *json_get_string(j2));
+        result = json_string_equal(j1, j2);
         break;
     case JSON_TYPE_BOOL:
-        result = j1.inner.boolean == j2.inner.boolean;
+        result = json_get_bool(j1) == json_get_bool(j2);
         break;
     case JSON_TYPE_NULL:
         result = true;
@@ -171,7 +419,7 @@ bool json_equal(Json j1, Json j2) {
             result = false;
             break;
         }
-        if (j1.list_inner_type != j2.list_inner_type) {
+        if (json_ptr_list(j1)->inner_type != json_ptr_list(j2)->inner_type) {
             result = false;
             break;
         }
@@ -195,6 +443,163 @@ bool json_equal(Json j1, Json j2) {
     return result;
 }
 
+/// Where values of `type` go when values of different types are ordered.
+static int type_order(JsonType type) {
+    switch (type) {
+    case JSON_TYPE_NULL:
+        return 0;
+    case JSON_TYPE_BOOL:
+        return 1;
+    case JSON_TYPE_NUMBER:
+        return 2;
+    case JSON_TYPE_STRING:
+        return 3;
+    case JSON_TYPE_LIST:
+        return 4;
+    case JSON_TYPE_OBJECT:
+        return 5;
+    default:
+        return 6;
+    }
+}
+
+/// Orders two json values, returning a negative number if `j1` comes first, a positive one if `j2`
+/// does and 0 if neither does.
+///
+/// Values of different types are ordered null, booleans, numbers, strings, lists and then objects.
+/// Lists are ordered by their elements, and objects by their fields in the order they're in.
+int json_compare(Json j1, Json j2) {
+    JsonType type = json_get_type(j1);
+    if (type != json_get_type(j2)) {
+        return type_order(type) - type_order(json_get_type(j2));
+    }
+
+    switch (type) {
+    case JSON_TYPE_NUMBER: {
+        double n1 = json_get_number(j1);
+        double n2 = json_get_number(j2);
+        return (n1 > n2) - (n1 < n2);
+    }
+    case JSON_TYPE_STRING:
+        return string_compare(*json_get_string(j1), *json_get_string(j2));
+    case JSON_TYPE_BOOL:
+        return json_get_bool(j1) - json_get_bool(j2);
+    case JSON_TYPE_LIST: {
+        JsonList *l1 = json_get_list(j1);
+        JsonList *l2 = json_get_list(j2);
+        for (size_t i = 0; i < l1->length && i < l2->length; i++) {
+            int cmp = json_compare(l1->data[i], l2->data[i]);
+            if (cmp != 0) {
+                return cmp;
+            }
+        }
+        return (l1->length > l2->length) - (l1->length < l2->length);
+    }
+    case JSON_TYPE_OBJECT: {
+        JsonObject *o1 = json_get_object(j1);
+        JsonObject *o2 = json_get_object(j2);
+        for (size_t i = 0; i < o1->length && i < o2->length; i++) {
+            int cmp = json_compare(o1->data[i].key, o2->data[i].key);
+            if (cmp == 0) {
+                cmp = json_compare(o1->data[i].value, o2->data[i].value);
+            }
+            if (cmp != 0) {
+                return cmp;
+            }
+        }
+        return (o1->length > o2->length) - (o1->length < o2->length);
+    }
+    default:
+        return 0;
+    }
+}
+
+/// Numbers are hashed by the cell of this width that they're in, where integers are in the middle
+/// of a cell. Cells are a lot wider than EPSILON, so only numbers right at the edge of one can be
+/// equal to numbers in another.
+#define HASH_CELL_WIDTH 0.000001
+
+/// From 2^26 on doubles that differ are more than EPSILON apart, so numbers that are `json_equal`
+/// are the same double and they're hashed by their bits.
+#define HASH_EXACT_NUMBERS 67108864.0
+
+static uint64_t hash_mix(uint64_t h, uint64_t value) {
+    h = (h ^ value) * 0x9e3779b97f4a7c15ull;
+    return h ^ (h >> 29);
+}
+
+static uint64_t hash_number(double n, int64_t offset) {
+    if (fabs(n) >= HASH_EXACT_NUMBERS || isnan(n)) {
+        uint64_t bits;
+        memcpy(&bits, &n, sizeof(bits));
+        return hash_mix(JSON_TYPE_NUMBER, bits);
+    }
+    // Integers and short decimals are in the middle of their cell, far from its edges
+    int64_t cell = (int64_t)floor(n / HASH_CELL_WIDTH + 0.5) + offset;
+    return hash_mix(JSON_TYPE_NUMBER, (uint64_t)cell);
+}
+
+/// A hash of `j` that is the same for values that are `json_equal`, for using json as the key of a
+/// hash table.
+///
+/// Numbers that are within EPSILON of each other can still end up in different cells, when they
+/// are right at the edge of one. `json_hash_other_cell` gives the hash that such a number can have
+/// as well, it's only checked for numbers that are keys themselves and not part of a key.
+uint64_t json_hash(Json j) {
+    uint64_t h = json_get_type(j);
+
+    switch (json_get_type(j)) {
+    case JSON_TYPE_NUMBER:
+        return hash_number(json_get_number(j), 0);
+    case JSON_TYPE_STRING:
+        return hash_mix(h, json_string_hash(j));
+    case JSON_TYPE_BOOL:
+        return hash_mix(h, json_get_bool(j));
+    case JSON_TYPE_OBJECT: {
+        JsonObject *object = json_get_object(j);
+        for (size_t i = 0; i < object->length; i++) {
+            h = hash_mix(h, json_hash(object->data[i].key));
+            h = hash_mix(h, json_hash(object->data[i].value));
+        }
+        return hash_mix(h, object->length);
+    }
+    case JSON_TYPE_LIST: {
+        JsonList *list = json_get_list(j);
+        for (size_t i = 0; i < list->length; i++) {
+            h = hash_mix(h, json_hash(list->data[i]));
+        }
+        return hash_mix(hash_mix(h, json_ptr_list(j)->inner_type), list->length);
+    }
+    default:
+        return hash_mix(h, 0);
+    }
+}
+
+/// For a number that is right at the edge of the cell it's hashed by, sets `hash` to the hash it
+/// would have in the cell next to it and returns true, see `json_hash`.
+bool json_hash_other_cell(Json j, uint64_t *hash) {
+    if (json_get_type(j) != JSON_TYPE_NUMBER) {
+        return false;
+    }
+    double n = json_get_number(j);
+    if (fabs(n) >= HASH_EXACT_NUMBERS || isnan(n)) {
+        return false;
+    }
+
+    double position = n / HASH_CELL_WIDTH + 0.5;
+    double from_edge = (position - floor(position)) * HASH_CELL_WIDTH;
+    // Some slack for the rounding of the division
+    if (from_edge <= 4 * EPSILON) {
+        *hash = hash_number(n, -1);
+        return true;
+    }
+    if (HASH_CELL_WIDTH - from_edge <= 4 * EPSILON) {
+        *hash = hash_number(n, 1);
+        return true;
+    }
+    return false;
+}
+
 Json json_copy(Json j) {
     refcnt_inc(j);
     return j;
@@ -202,7 +607,7 @@ Json json_copy(Json j) {
 
 Json json_clone(Json j) {
     Json new;
-    switch (j.type) {
+    switch (json_get_type(j)) {
     case JSON_TYPE_INVALID:
     case JSON_TYPE_ANY:
     case JSON_TYPE_NUMBER:
@@ -244,38 +649,36 @@ void json_free(Json j) {
         return;
     }
 
-    switch (j.type) {
+    // Lazy lists/objects must not be parsed just to be freed, so access `d` directly here.
+    switch (json_get_type(j)) {
     case JSON_TYPE_OBJECT:
-        obj = json_get_object(j);
+        obj = &json_ptr_object(j)->d;
         for (int i = 0; i < obj->length; i++) {
             json_free(obj->data[i].value);
             json_free(obj->data[i].key);
         }
-        free(obj->data);
-        free(json_ptr_object(j));
+        jrq_free(obj->data);
+        refcnt_free(json_ref(j), JSON_TYPE_OBJECT);
         break;
     case JSON_TYPE_LIST:
-        list = json_get_list(j);
+        list = &json_ptr_list(j)->d;
         for (int i = 0; i < list->length; i++) {
             json_free(list->data[i]);
         }
-        free(list->data);
-        free(json_ptr_list(j));
+        jrq_free(list->data);
+        refcnt_free(json_ref(j), JSON_TYPE_LIST);
         break;
     case JSON_TYPE_STRING:
-        // If there is no capacity, then the string was not allocated as a json string
-        if (json_ptr_string(j)->d.capacity == 0) {
-            free(json_ptr_string(j));
-            break;
-        }
-        if (!json_is_null(json_ptr_string(j)->borrowed_string)) {
+        if (json_ptr_string(j)->is_small) {
+            // The string is part of the header
+        } else if (json_get_type(json_ptr_string(j)->borrowed_string) == JSON_TYPE_STRING) {
             // If the string is a substring, we should free the string we're borrowing from
             json_free(json_ptr_string(j)->borrowed_string);
-        } else {
-            // if the string is not a substring, we can free the data like normal.
-            free(json_ptr_string(j)->d.data);
+        } else if (json_ptr_string(j)->d.capacity != 0) {
+            // If there is no capacity, then the string is borrowed and its data isn't ours to free
+            jrq_free(json_ptr_string(j)->d.data);
         }
-        free(json_ptr_string(j));
+        refcnt_free(json_ref(j), JSON_TYPE_STRING);
         break;
     case JSON_TYPE_NULL:
     case JSON_TYPE_NUMBER:
@@ -287,12 +690,42 @@ void json_free(Json j) {
 }
 
 bool json_is_null(Json j) {
-    return j.type == JSON_TYPE_NULL;
+    return json_get_type(j) == JSON_TYPE_NULL;
 }
 bool json_is_invalid(Json j) {
-    return j.type == JSON_TYPE_INVALID;
+    return json_get_type(j) == JSON_TYPE_INVALID;
 }
 
+#ifdef JSON_NAN_BOXING
+Json json_number(double f) {
+    uint64_t bits = CANONICAL_NAN;
+    if (!isnan(f)) {
+        memcpy(&bits, &f, sizeof(bits));
+    }
+    return (Json) {.bits = bits + JSON_NUMBER_OFFSET};
+}
+Json json_boolean(bool boolean) {
+    return json_tagged(JSON_TYPE_BOOL, boolean);
+}
+Json json_null(void) {
+    return json_tagged(JSON_TYPE_NULL, 0);
+}
+Json json_invalid(void) {
+    return json_tagged(JSON_TYPE_INVALID, 0);
+}
+
+double json_get_number(Json j) {
+    assert(json_get_type(j) == JSON_TYPE_NUMBER);
+    uint64_t bits = j.bits - JSON_NUMBER_OFFSET;
+    double f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+bool json_get_bool(Json j) {
+    assert(json_get_type(j) == JSON_TYPE_BOOL);
+    return j.bits & 1;
+}
+#else
 Json json_number(double f) {
     return (Json) {.type = JSON_TYPE_NUMBER, .inner.number = f};
 }
@@ -307,24 +740,53 @@ Json json_invalid(void) {
 }
 
 double json_get_number(Json j) {
-    assert(j.type == JSON_TYPE_NUMBER);
+    assert(json_get_type(j) == JSON_TYPE_NUMBER);
     return j.inner.number;
 }
 bool json_get_bool(Json j) {
-    assert(j.type == JSON_TYPE_BOOL);
+    assert(json_get_type(j) == JSON_TYPE_BOOL);
     return j.inner.boolean;
 }
+#endif
 String *json_get_string(Json j) {
-    assert(j.type == JSON_TYPE_STRING);
+    assert(json_get_type(j) == JSON_TYPE_STRING);
     return &json_ptr_string(j)->d;
 }
 JsonList *json_get_list(Json j) {
-    assert(j.type == JSON_TYPE_LIST);
-    return &json_ptr_list(j)->d;
+    assert(json_get_type(j) == JSON_TYPE_LIST);
+
+    JsonListRef *ref = json_ptr_list(j);
+    if (ref->lazy != NULL) {
+        Json parsed = json_materialize(ref->lazy);
+        assert(json_get_type(parsed) == JSON_TYPE_LIST);
+
+        // Steal the elements from the freshly parsed list
+        ref->d = json_ptr_list(parsed)->d;
+        ref->lazy = NULL;
+        refcnt_free(json_ref(parsed), JSON_TYPE_LIST);
+    }
+    return &ref->d;
 }
 JsonObject *json_get_object(Json j) {
-    assert(j.type == JSON_TYPE_OBJECT);
-    return &json_ptr_object(j)->d;
+    assert(json_get_type(j) == JSON_TYPE_OBJECT);
+
+    JsonObjectRef *ref = json_ptr_object(j);
+    if (ref->lazy != NULL) {
+        Json parsed = json_materialize(ref->lazy);
+        assert(json_get_type(parsed) == JSON_TYPE_OBJECT);
+
+        // Drop the fields cached by `json_object_get`, the parsed object has all of them.
+        for (int i = 0; i < ref->d.length; i++) {
+            json_free(ref->d.data[i].key);
+            json_free(ref->d.data[i].value);
+        }
+        jrq_free(ref->d.data);
+
+        ref->d = json_ptr_object(parsed)->d;
+        ref->lazy = NULL;
+        refcnt_free(json_ref(parsed), JSON_TYPE_OBJECT);
+    }
+    return &ref->d;
 }
 
 // Json json_invalid_msg(char *format, ...) {
@@ -347,59 +809,76 @@ Json json_list_sized(size_t i) {
     JsonList d = {0};
     vec_grow(d, i);
 
-    JsonListRef *ref = (JsonListRef *)refcnt_init(sizeof(*ref));
+    JsonListRef *ref = (JsonListRef *)refcnt_init(sizeof(*ref), JSON_TYPE_LIST);
     ref->d = d;
 
-    return (Json) {
-        .type = JSON_TYPE_LIST,
-        .inner.ptr = (RefCnt *)ref,
-        .list_inner_type = 0,
-    };
+    return json_from_ref(JSON_TYPE_LIST, (RefCnt *)ref);
 }
 
 Json json_list(void) {
     return json_list_sized(16);
 }
 
-static void list_set_inner_type(Json *j, JsonType inner) {
-    if (j->list_inner_type == JSON_TYPE_INVALID) {
-        j->list_inner_type = inner;
-    } else if (j->list_inner_type != inner) {
-        j->list_inner_type = JSON_TYPE_ANY;
+/// Create a list that will be parsed from `source` the first time its elements are accessed.
+///
+/// `source` must point to the opening `[` of an already validated list, and `inner_type` must be
+/// the type the list would have after appending all of its elements.
+Json json_list_lazy(char *source, JsonType inner_type) {
+    JsonListRef *ref = (JsonListRef *)refcnt_init(sizeof(*ref), JSON_TYPE_LIST);
+    ref->lazy = source;
+    ref->inner_type = inner_type;
+
+    return json_from_ref(JSON_TYPE_LIST, (RefCnt *)ref);
+}
+
+static void list_set_inner_type(Json j, JsonType inner) {
+    JsonListRef *ref = json_ptr_list(j);
+    if (ref->inner_type == JSON_TYPE_INVALID) {
+        ref->inner_type = inner;
+    } else if (ref->inner_type != inner) {
+        ref->inner_type = JSON_TYPE_ANY;
     }
 }
 
 Json json_list_append(Json j, Json el) {
-    assert(j.type == JSON_TYPE_LIST);
+    assert(json_get_type(j) == JSON_TYPE_LIST);
 
-    list_set_inner_type(&j, el.type);
-    vec_append(json_ptr_list(j)->d, el);
+    list_set_inner_type(j, json_get_type(el));
+    vec_append(*json_get_list(j), el);
     return j;
 }
 
 Json json_list_get(Json j, uint index) {
-    assert(j.type == JSON_TYPE_LIST);
+    assert(json_get_type(j) == JSON_TYPE_LIST);
 
-    return json_ptr_list(j)->d.data[index];
+    return json_get_list(j)->data[index];
 }
 
 JsonType json_list_get_inner_type(Json j) {
-    assert(j.type == JSON_TYPE_LIST);
+    assert(json_get_type(j) == JSON_TYPE_LIST);
 
-    return j.list_inner_type;
+    return json_ptr_list(j)->inner_type;
+}
+
+/// Set the type of the elements of `j`, for when they were added without `json_list_append`
+/// or stand in for elements that weren't parsed.
+void json_list_set_inner_type(Json j, JsonType inner) {
+    assert(json_get_type(j) == JSON_TYPE_LIST);
+
+    json_ptr_list(j)->inner_type = inner;
 }
 
 size_t json_list_length(Json j) {
-    assert(j.type == JSON_TYPE_LIST);
+    assert(json_get_type(j) == JSON_TYPE_LIST);
 
-    return json_ptr_list(j)->d.length;
+    return json_get_list(j)->length;
 }
 
 // Don't use this, it's not implemented well
 // Json json_list_set(Json j, uint index, Json val) {
-//     assert(j.type == JSON_TYPE_LIST);
+//     assert(json_get_type(j) == JSON_TYPE_LIST);
 //
-//     list_set_inner_type(&j, val.type);
+//     list_set_inner_type(j, json_get_type(val));
 //     json_ptr_list(j)->d.data[index] = val;
 //
 //     return j;
@@ -409,26 +888,33 @@ Json json_object_sized(size_t i) {
     JsonObject d = {0};
     vec_grow(d, i);
 
-    JsonObjectRef *ref = (JsonObjectRef *)refcnt_init(sizeof(*ref));
+    JsonObjectRef *ref = (JsonObjectRef *)refcnt_init(sizeof(*ref), JSON_TYPE_OBJECT);
     ref->d = d;
 
-    return (Json) {
-        .type = JSON_TYPE_OBJECT,
-        .inner.ptr = (RefCnt *)ref,
-    };
+    return json_from_ref(JSON_TYPE_OBJECT, (RefCnt *)ref);
 }
 
 Json json_object() {
     return json_object_sized(16);
 }
 
+/// Create an object that will be parsed from `source` when it is accessed.
+///
+/// `source` must point to the opening `{` of an already validated object.
+Json json_object_lazy(char *source) {
+    JsonObjectRef *ref = (JsonObjectRef *)refcnt_init(sizeof(*ref), JSON_TYPE_OBJECT);
+    ref->lazy = source;
+
+    return json_from_ref(JSON_TYPE_OBJECT, (RefCnt *)ref);
+}
+
 Json json_object_set(Json j, Json key, Json value) {
-    assert(j.type == JSON_TYPE_OBJECT);
-    assert(key.type == JSON_TYPE_STRING);
+    assert(json_get_type(j) == JSON_TYPE_OBJECT);
+    assert(json_get_type(key) == JSON_TYPE_STRING);
 
     JsonObject *obj = json_get_object(j);
     for (int i = 0; i < obj->length; i++) {
-        if (json_equal(obj->data[i].key, key)) {
+        if (json_string_equal(obj->data[i].key, key)) {
 
             json_free(obj->data[i].value);
             json_free(key);
@@ -442,14 +928,24 @@ Json json_object_set(Json j, Json key, Json value) {
 }
 
 Json json_object_get(Json j, Json key) {
-    assert(j.type == JSON_TYPE_OBJECT);
-    assert(key.type == JSON_TYPE_STRING);
+    assert(json_get_type(j) == JSON_TYPE_OBJECT);
+    assert(json_get_type(key) == JSON_TYPE_STRING);
 
-    JsonObject *obj = json_get_object(j);
+    JsonObjectRef *ref = json_ptr_object(j);
 
-    for (int i = 0; i < obj->length; i++) {
-        if (json_equal(obj->data[i].key, key)) {
-            return obj->data[i].value;
+    // When the object is lazy, this only searches the fields that were already looked up.
+    for (int i = 0; i < ref->d.length; i++) {
+        if (json_string_equal(ref->d.data[i].key, key)) {
+            return ref->d.data[i].value;
+        }
+    }
+
+    if (ref->lazy != NULL) {
+        // Only parse the field we're looking for, the others are skipped over.
+        Json value = json_materialize_field(ref->lazy, *json_get_string(key));
+        if (!json_is_invalid(value)) {
+            vec_append(ref->d, (JsonObjectPair) {.key = json_copy(key), .value = value});
+            return value;
         }
     }
 
@@ -457,58 +953,220 @@ Json json_object_get(Json j, Json key) {
 }
 
 size_t json_object_length(Json j) {
-    assert(j.type == JSON_TYPE_OBJECT);
+    assert(json_get_type(j) == JSON_TYPE_OBJECT);
 
     return json_get_object(j)->length;
 }
 
+/// Create a string that is stored in its header, `length` can be at most `SMALL_STRING_LENGTH`.
+static Json json_small_string(const char *str, size_t length) {
+    assert(length <= SMALL_STRING_LENGTH);
+
+    JsonStringRef *s = (JsonStringRef *)refcnt_init(sizeof(*s), JSON_TYPE_STRING);
+    s->is_small = true;
+    memcpy(s->small, str, length);
+    s->small[length] = '\0';
+    s->d = string_from_str(s->small, length);
+
+    // It's cheap to check whether such a short string can be serialized without escaping, and
+    // whether it's only ascii
+    s->plain = true;
+    s->ascii = ASCII_ONLY;
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = str[i];
+        if (c < 0x20 || c == '"' || c == '\\') {
+            s->plain = false;
+        }
+        if (c >= 0x80) {
+            s->ascii = ASCII_NOT_ONLY;
+        }
+    }
+
+    return json_from_ref(JSON_TYPE_STRING, (RefCnt *)s);
+}
+
 Json json_string(const char *str) {
-    JsonStringRef *s = (JsonStringRef *)refcnt_init(sizeof(*s));
+    size_t length = strlen(str);
+    if (length <= SMALL_STRING_LENGTH) {
+        return json_small_string(str, length);
+    }
+
+    JsonStringRef *s = (JsonStringRef *)refcnt_init(sizeof(*s), JSON_TYPE_STRING);
 
-    s->d = string_from_chars_alloc((char *)str);
+    s->d = string_from_str_alloc((char *)str, length);
     s->borrowed_string = json_null();
 
-    return (Json) {.type = JSON_TYPE_STRING, .inner.ptr = (RefCnt *)s};
+    return json_from_ref(JSON_TYPE_STRING, (RefCnt *)s);
 }
 
+/// Create a json string out of `str`.
+///
+/// If `str` is allocated (has a capacity), the json string takes ownership of it. Otherwise `str`
+/// is borrowed, and it must be a slice of json source text without escape sequences, which is the
+/// only kind of borrowed string the lexer produces.
 Json json_string_from(String str) {
-    JsonStringRef *s = (JsonStringRef *)refcnt_init(sizeof(*s));
+    if (str.capacity != 0 && str.length <= SMALL_STRING_LENGTH) {
+        Json small = json_small_string(str.data, str.length);
+        jrq_free(str.data);
+        return small;
+    }
+
+    JsonStringRef *s = (JsonStringRef *)refcnt_init(sizeof(*s), JSON_TYPE_STRING);
     s->d = str;
-    s->d.capacity = 0;
-    return (Json) {.type = JSON_TYPE_STRING, .inner.ptr = (RefCnt *)s};
+    s->borrowed_string = json_null();
+    s->plain = str.capacity == 0;
+    return json_from_ref(JSON_TYPE_STRING, (RefCnt *)s);
 }
 
-/// Create a json string out of the substring of another string.
+/// The hash of the bytes of `j`, which is computed once and then kept with the string.
+uint64_t json_string_hash(Json j) {
+    assert(json_get_type(j) == JSON_TYPE_STRING);
+
+    JsonStringRef *s = json_ptr_string(j);
+    if (!s->hashed) {
+        s->hash = string_hash(s->d);
+        s->hashed = true;
+    }
+    return s->hash;
+}
+
+/// The amount of utf-8 codepoints in `j`, which is its length if it is only ascii.
+///
+/// Whether it is only ascii is kept with the string, so for those this takes constant time after
+/// the first call.
+size_t json_string_codepoints(Json j) {
+    assert(json_get_type(j) == JSON_TYPE_STRING);
+
+    JsonStringRef *s = json_ptr_string(j);
+    if (s->ascii == ASCII_ONLY) {
+        return s->d.length;
+    }
+    size_t codepoints = string_codepoints(s->d);
+    s->ascii = codepoints == s->d.length ? ASCII_ONLY : ASCII_NOT_ONLY;
+    return codepoints;
+}
+
+/// The substring of the codepoints from `start` up to `end` of `j`, both are limited to the amount
+/// of codepoints in `j`.
+Json json_string_slice(Json j, size_t start, size_t end) {
+    assert(json_get_type(j) == JSON_TYPE_STRING);
+
+    JsonStringRef *s = json_ptr_string(j);
+    size_t from, to;
+    if (s->ascii == ASCII_ONLY) {
+        from = start < s->d.length ? start : s->d.length;
+        to = end < s->d.length ? end : s->d.length;
+    } else {
+        from = string_codepoint_offset(s->d, start);
+        String rest = string_from_str(s->d.data + from, s->d.length - from);
+        to = end > start ? from + string_codepoint_offset(rest, end - start) : from;
+    }
+    return json_substring(j, from, to > from ? to - from : 0);
+}
+
+/// Whether `j` can be serialized without escaping anything, see `JsonStringRef.plain`.
+bool json_string_is_plain(Json j) {
+    assert(json_get_type(j) == JSON_TYPE_STRING);
+
+    return json_ptr_string(j)->plain;
+}
+
+/// Create a json string out of the `length` bytes at `offset` of another string.
 ///
 /// This will NOT allocate a new string, instead it will borrow from the original string.
 ///
 /// The original string will have another reference added to it, and when the substring is freed,
-/// the original string will have a reference removed.
+/// the original string will have a reference removed. Small substrings are copied instead, so they
+/// don't keep the original string alive.
 Json json_substring(Json str, size_t offset, size_t length) {
-    assert(str.type == JSON_TYPE_STRING);
+    assert(json_get_type(str) == JSON_TYPE_STRING);
+
+    String *original = json_get_string(str);
+    if (length <= SMALL_STRING_LENGTH) {
+        return json_small_string(original->data + offset, length);
+    }
 
-    JsonStringRef *s = (JsonStringRef *)refcnt_init(sizeof(*s));
-    s->d = json_ptr_string(str)->d;
+    JsonStringRef *s = (JsonStringRef *)refcnt_init(sizeof(*s), JSON_TYPE_STRING);
+    s->d = *original;
     s->d.data += offset;
-    s->d.length = length + 1;
+    s->d.length = length;
     s->d.capacity = 0;
+    // A slice of a string that needs no escaping doesn't either, and the same goes for ascii
+    s->plain = json_ptr_string(str)->plain;
+    s->ascii = json_ptr_string(str)->ascii == ASCII_ONLY ? ASCII_ONLY : ASCII_UNKNOWN;
 
     s->borrowed_string = str;
     refcnt_inc(str);
-    return (Json) {.type = JSON_TYPE_STRING, .inner.ptr = (RefCnt *)s};
+    return json_from_ref(JSON_TYPE_STRING, (RefCnt *)s);
 }
 
 Json json_string_concat(Json j, Json str) {
-    assert(j.type == JSON_TYPE_STRING);
-    assert(str.type == JSON_TYPE_STRING);
-    assert(json_get_string(j)->capacity != 0);
+    assert(json_get_type(j) == JSON_TYPE_STRING);
+    assert(json_get_type(str) == JSON_TYPE_STRING);
+
+    JsonStringRef *s = json_ptr_string(j);
+    String *append = json_get_string(str);
+    s->hashed = false;
+    if (s->ascii != ASCII_ONLY || json_ptr_string(str)->ascii != ASCII_ONLY) {
+        s->ascii = ASCII_UNKNOWN;
+    }
+    if (s->is_small) {
+        if (s->d.length + append->length <= SMALL_STRING_LENGTH) {
+            memcpy(s->small + s->d.length, append->data, append->length);
+            s->d.length += append->length;
+            s->small[s->d.length] = '\0';
+            s->plain = s->plain && json_string_is_plain(str);
+            return j;
+        }
 
-    string_append(json_get_string(j), *json_get_string(str));
+        // It doesn't fit anymore, move it into a buffer of its own
+        s->d = string_from_str_alloc(s->small, s->d.length);
+        s->is_small = false;
+        s->borrowed_string = json_null();
+    } else if (s->d.capacity == 0) {
+        // Borrowed strings are copied into a buffer of their own before they can be appended to
+        Json borrowed = s->borrowed_string;
+        s->d = string_from_str_alloc(s->d.data, s->d.length);
+        s->borrowed_string = json_null();
+        json_free(borrowed);
+    }
+
+    string_append(&s->d, *append);
+    // Appending could add something that has to be escaped
+    s->plain = false;
     return j;
 }
 
+/// Concatenates two strings, consuming both of them.
+///
+/// When nothing else holds a reference to `a` it is appended to in place, and its buffer grows by
+/// doubling. A chain of `+` then builds its result in one buffer instead of copying everything
+/// that came before for every piece.
+Json json_string_add(Json a, Json b) {
+    assert(json_get_type(a) == JSON_TYPE_STRING);
+    assert(json_get_type(b) == JSON_TYPE_STRING);
+
+    if (refcnt_get(a) == 1) {
+        json_string_concat(a, b);
+        json_free(b);
+        return a;
+    }
+
+    String *first = json_get_string(a);
+    String *second = json_get_string(b);
+    size_t length = first->length + second->length;
+    String d = {.data = jrq_malloc(length + 1), .length = length, .capacity = length + 1};
+    memcpy(d.data, first->data, first->length);
+    memcpy(d.data + first->length, second->data, second->length);
+    d.data[length] = '\0';
+
+    json_free(a);
+    json_free(b);
+    return json_string_from(d);
+}
+
 size_t json_string_length(Json j) {
-    assert(j.type == JSON_TYPE_STRING);
+    assert(json_get_type(j) == JSON_TYPE_STRING);
 
     return json_ptr_string(j)->d.length;
 }
@@ -23,6 +23,26 @@ typedef Vec(struct Json) JsonList;
 typedef Vec(struct JsonObjectPair) JsonObject;
 struct RefCnt;
 
+#ifdef JSON_NAN_BOXING
+
+/// A json value packed into 8 bytes.
+///
+/// Numbers are stored as the bits of their double plus `JSON_NUMBER_OFFSET`, with every NaN being
+/// the same one. That leaves all bit patterns below the offset free for the other types: their
+/// type is in bits 48 to 50 and a pointer or boolean in the lower 48 bits. All zeroes is invalid.
+typedef struct Json {
+    uint64_t bits;
+} Json;
+
+#define JSON_NUMBER_OFFSET (1ull << 51)
+#define JSON_PAYLOAD_MASK ((1ull << 48) - 1)
+
+static inline JsonType json_get_type(Json j) {
+    return j.bits < JSON_NUMBER_OFFSET ? (JsonType)(j.bits >> 48) : JSON_TYPE_NUMBER;
+}
+
+#else
+
 typedef struct Json {
     union {
         double number;
@@ -30,27 +50,50 @@ typedef struct Json {
         struct RefCnt *ptr;
     } inner;
     JsonType type;
-    JsonType list_inner_type;
 } Json;
 
+static inline JsonType json_get_type(Json j) {
+    return j.type;
+}
+
+#endif
+
 typedef struct JsonObjectPair {
     Json value;
     Json key;
 } JsonObjectPair;
 
+/// How many lists, objects and strings have been created so far, indexed by their type. Only
+/// counted while `json_count_created` is set, which keeps the atomic increment off the hot path of
+/// every other run.
+extern size_t json_created[JSON_TYPE_LIST + 1];
+extern bool json_count_created;
+
+void json_pool_release(void);
+
 bool json_equal(Json, Json);
+int json_compare(Json, Json);
+uint64_t json_hash(Json);
+bool json_hash_other_cell(Json, uint64_t *);
 Json json_copy(Json);
+uint refcnt_get(Json);
 void json_free(Json);
 
 bool json_is_null(Json);
 bool json_is_invalid(Json);
 
 char *json_type(Json);
+char *json_list_type(JsonType inner);
+char *json_type_name(JsonType type);
 
 Json json_number(double f);
 Json json_string(const char *);
 Json json_string_from(String);
 Json json_substring(Json, size_t, size_t);
+bool json_string_is_plain(Json);
+uint64_t json_string_hash(Json);
+size_t json_string_codepoints(Json);
+Json json_string_slice(Json, size_t, size_t);
 Json json_boolean(bool);
 Json json_null(void);
 Json json_list(void);
@@ -65,13 +108,16 @@ JsonList *json_get_list(Json j);
 JsonObject *json_get_object(Json j);
 
 Json json_string_concat(Json j, Json str);
+Json json_string_add(Json a, Json b);
 size_t json_string_length(Json j);
 
 Json json_list_append(Json, Json);
 Json json_list_sized(size_t);
+Json json_list_lazy(char *, JsonType);
 Json json_list_get(Json, uint);
 Json json_list_set(Json j, uint index, Json val);
 JsonType json_list_get_inner_type(Json j);
+void json_list_set_inner_type(Json j, JsonType inner);
 size_t json_list_length(Json j);
 
 // clang-format off
@@ -93,6 +139,7 @@ size_t json_list_length(Json j);
     )
 
 Json json_object_sized(size_t);
+Json json_object_lazy(char *);
 Json json_object_set(Json j, Json key, Json value);
 Json json_object_get(Json j, Json key);
 size_t json_object_length(Json);
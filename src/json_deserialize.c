@@ -2,16 +2,26 @@
 #include "src/json.h"
 #include "src/json_serde.h"
 #include "src/lexer.h"
+#include "src/projection.h"
+#include "src/vector.h"
 #include <memory.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 
 #define LIST(v...) (v), (sizeof(v) / sizeof(*v))
 
-static Json parse_json(Parser *p);
-static Json parse_list(Parser *p);
-static Json parse_object(Parser *p);
+#define ERROR_INVALID_NUMBER "Invalid numerical literal"
 
-Json parse_object(Parser *p) {
+static Json parse_json(Parser *p, bool lazy);
+static Json parse_list(Parser *p, bool lazy);
+static Json parse_object(Parser *p, bool lazy);
+static Json parse_lazy(Parser *p);
+
+static void skip_json(Parser *p);
+
+Json parse_object(Parser *p, bool lazy) {
     Json obj = json_object();
 
     if (p->curr.type != TOKEN_RBRACE) {
@@ -22,7 +32,7 @@ Json parse_object(Parser *p) {
                 return json_invalid();
             }
 
-            Json key = json_string_from(p->prev.inner.string);
+            Json key = json_string_from(tok_take_string(&p->prev));
 
             parser_expect(p, TOKEN_COLON, ERROR_EXPECTED_COLON);
             if (p->error != NULL) {
@@ -31,7 +41,7 @@ Json parse_object(Parser *p) {
                 return json_invalid();
             }
 
-            Json value = parse_json(p);
+            Json value = parse_json(p, lazy);
             obj = json_object_set(obj, key, value);
         } while (parser_matches(p, LIST((TokenType[]) {TOKEN_COMMA})));
     }
@@ -45,12 +55,12 @@ Json parse_object(Parser *p) {
     return obj;
 }
 
-Json parse_list(Parser *p) {
+Json parse_list(Parser *p, bool lazy) {
     Json j = json_list();
 
     if (p->curr.type != TOKEN_RBRACKET) {
         do {
-            j = json_list_append(j, parse_json(p));
+            j = json_list_append(j, parse_json(p, lazy));
         } while (parser_matches(p, LIST((TokenType[]) {TOKEN_COMMA})));
     }
 
@@ -64,14 +74,23 @@ Json parse_list(Parser *p) {
     return j;
 }
 
-static Json parse_json(Parser *p) {
+/// Parses the value at the current token.
+///
+/// If `lazy` is true, lists and objects are not parsed, instead they are skipped over and left to
+/// be parsed when they are first accessed. This should only be used on input that was validated
+/// by `skip_json` first.
+static Json parse_json(Parser *p, bool lazy) {
+    if (lazy && (p->curr.type == TOKEN_LBRACE || p->curr.type == TOKEN_LBRACKET)) {
+        return parse_lazy(p);
+    }
+
     // clang-format off
     if (parser_matches(p, LIST((TokenType[]) {TOKEN_TRUE}))) return json_boolean(true);
     if (parser_matches(p, LIST((TokenType[]) {TOKEN_FALSE}))) return json_boolean(false);
     if (parser_matches(p, LIST((TokenType[]) {TOKEN_NULL}))) return json_null();
 
-    if (parser_matches(p, LIST((TokenType[]) {TOKEN_LBRACE}))) return parse_object(p);
-    if (parser_matches(p, LIST((TokenType[]) {TOKEN_LBRACKET}))) return parse_list(p);
+    if (parser_matches(p, LIST((TokenType[]) {TOKEN_LBRACE}))) return parse_object(p, lazy);
+    if (parser_matches(p, LIST((TokenType[]) {TOKEN_LBRACKET}))) return parse_list(p, lazy);
     // clang-format on
 
     if (parser_matches(p, LIST((TokenType[]) {TOKEN_STRING, TOKEN_MINUS, TOKEN_NUMBER}))) {
@@ -79,11 +98,11 @@ static Json parse_json(Parser *p) {
 
         switch (t.type) {
         case TOKEN_STRING:
-            return json_string_from(t.inner.string);
+            return json_string_from(tok_take_string(&p->prev));
         case TOKEN_NUMBER:
             return json_number(t.inner.number);
         case TOKEN_MINUS:
-            parser_expect(p, TOKEN_NUMBER, "Invalid numerical literal");
+            parser_expect(p, TOKEN_NUMBER, ERROR_INVALID_NUMBER);
             RETURN_ERR(p, json_invalid())
             t = p->prev;
             return json_number(-t.inner.number);
@@ -99,6 +118,15 @@ static Json parse_json(Parser *p) {
     return (Json) {0};
 }
 
+static DeserializeResult deserialize_error(Parser *p) {
+    tok_free(&p->curr);
+    tok_free(&p->prev);
+    return (DeserializeResult) {
+        .err = jrq_error(p->curr.range, "%s", p->error),
+        .type = RES_ERR,
+    };
+}
+
 DeserializeResult json_deserialize(char *str) {
     Lexer l = lex_init(str);
 
@@ -108,17 +136,616 @@ DeserializeResult json_deserialize(char *str) {
     };
 
     parser_next(&p);
-    Json j = parse_json(&p);
+    Json j = parse_json(&p, false);
+    parser_expect(&p, TOKEN_EOF, ERROR_EXPECTED_EOF);
+    if (p.error != NULL) {
+        json_free(j);
+        return deserialize_error(&p);
+    }
+
+    return (DeserializeResult) {.result = j};
+}
+
+/*********************
+ * Lazy deserializer *
+ *********************/
+
+static bool is_json_whitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/// The type a value will have, based on the first character of it.
+static JsonType value_type(char c) {
+    switch (c) {
+    case '{':
+        return JSON_TYPE_OBJECT;
+    case '[':
+        return JSON_TYPE_LIST;
+    case '"':
+        return JSON_TYPE_STRING;
+    case 't':
+    case 'f':
+        return JSON_TYPE_BOOL;
+    case 'n':
+        return JSON_TYPE_NULL;
+    default:
+        return JSON_TYPE_NUMBER;
+    }
+}
+
+/// Finds the end of the list or object starting at `start` by matching brackets and quotes.
+///
+/// This does no validation besides finding the end, so anything else that is wrong with the
+/// container goes unnoticed.
+///
+/// Returns a pointer to the character after the closing bracket, or NULL if the input ends before
+/// the container does. The type the list would get from `json_list_append`ing all of its elements
+/// is written to `inner_type` (this is `JSON_TYPE_INVALID` for objects and empty lists).
+static char *skip_container(char *start, JsonType *inner_type) {
+    bool is_list = *start == '[';
+    bool expect_element = is_list;
+    JsonType inner = JSON_TYPE_INVALID;
+    int depth = 0;
+
+    for (char *c = start;; c++) {
+        if (expect_element && depth == 1 && !is_json_whitespace(*c) && *c != ']') {
+            JsonType t = value_type(*c);
+            inner = (inner == JSON_TYPE_INVALID || inner == t) ? t : JSON_TYPE_ANY;
+            expect_element = false;
+        }
+
+        switch (*c) {
+        case '"':
+            c = lex_string_end(c);
+            if (*c == '\0') {
+                return NULL;
+            }
+            break;
+        case '\0':
+            return NULL;
+        case '[':
+        case '{':
+            depth++;
+            break;
+        case ']':
+        case '}':
+            if (--depth == 0) {
+                *inner_type = inner;
+                return c + 1;
+            }
+            break;
+        case ',':
+            expect_element = is_list && depth == 1;
+            break;
+        }
+    }
+}
+
+/// Skips over the list or object at the current token without lexing it.
+///
+/// Returns a pointer to the opening bracket of the container.
+static char *skip_lazy(Parser *p, JsonType *inner_type) {
+    // The current token was the last thing lexed, so the lexer is right after its bracket.
+    char *start = p->l->str - 1;
+    char *end = skip_container(start, inner_type);
+
+    if (end == NULL) {
+        lex_advance_to(p->l, start + strlen(start));
+        parser_next(p);
+        p->error = *start == '[' ? ERROR_MISSING_RBRACKET : ERROR_MISSING_RBRACE;
+        return start;
+    }
+
+    lex_advance_to(p->l, end);
+    parser_next(p);
+
+    return start;
+}
+
+/// Creates a lazy list or object out of the container at the current token.
+static Json parse_lazy(Parser *p) {
+    JsonType inner_type;
+    bool is_object = p->curr.type == TOKEN_LBRACE;
+    char *start = skip_lazy(p, &inner_type);
+
+    return is_object ? json_object_lazy(start) : json_list_lazy(start, inner_type);
+}
+
+static void skip_object(Parser *p) {
+    if (p->curr.type != TOKEN_RBRACE) {
+        do {
+            parser_expect(p, TOKEN_STRING, ERROR_EXPECTED_STRING);
+            parser_expect(p, TOKEN_COLON, ERROR_EXPECTED_COLON);
+            skip_json(p);
+        } while (parser_matches(p, LIST((TokenType[]) {TOKEN_COMMA})));
+    }
+
+    parser_expect(p, TOKEN_RBRACE, ERROR_MISSING_RBRACE);
+}
+
+static void skip_list(Parser *p) {
+    if (p->curr.type != TOKEN_RBRACKET) {
+        do {
+            skip_json(p);
+        } while (parser_matches(p, LIST((TokenType[]) {TOKEN_COMMA})));
+    }
+
+    parser_expect(p, TOKEN_RBRACKET, ERROR_MISSING_RBRACKET);
+}
+
+/// Validates the value at the current token without building anything.
+///
+/// Any error is reported exactly the way `parse_json` would report it.
+static void skip_json(Parser *p) {
+    // clang-format off
+    if (parser_matches(p, LIST((TokenType[]) {TOKEN_TRUE, TOKEN_FALSE, TOKEN_NULL, TOKEN_STRING, TOKEN_NUMBER}))) return;
+    if (parser_matches(p, LIST((TokenType[]) {TOKEN_LBRACE}))) return skip_object(p);
+    if (parser_matches(p, LIST((TokenType[]) {TOKEN_LBRACKET}))) return skip_list(p);
+    if (parser_matches(p, LIST((TokenType[]) {TOKEN_MINUS}))) return parser_expect(p, TOKEN_NUMBER, ERROR_INVALID_NUMBER);
+    // clang-format on
+
+    parser_expect(p, -1, ERROR_UNEXPECTED_TOKEN);
+}
+
+/// Deserialize `str` on demand.
+///
+/// The input is validated up front, so this fails exactly when `json_deserialize` would fail, but
+/// lists and objects are only parsed once they are accessed. Fields of an object that are looked
+/// up with `json_object_get` are parsed individually, and the rest of the object is skipped over.
+///
+/// The result borrows from `str`, so `str` must outlive it.
+DeserializeResult json_deserialize_lazy(char *str) {
+    Lexer l = lex_init(str);
+
+    Parser p = {
+        .l = &l,
+        .should_free = true,
+    };
+
+    parser_next(&p);
+    skip_json(&p);
+    parser_expect(&p, TOKEN_EOF, ERROR_EXPECTED_EOF);
+    if (p.error != NULL) {
+        return deserialize_error(&p);
+    }
+
+    l = lex_init(str);
+    p = (Parser) {
+        .l = &l,
+        .should_free = true,
+    };
+
+    parser_next(&p);
+    return (DeserializeResult) {.result = parse_json(&p, true)};
+}
+
+/// Parse the lazy list or object at `source`.
+///
+/// The lists and objects inside of it are left lazy.
+Json json_materialize(char *source) {
+    Lexer l = lex_init(source);
+
+    Parser p = {
+        .l = &l,
+        .should_free = true,
+    };
+
+    Json j;
+    parser_next(&p);
+    if (parser_matches(&p, LIST((TokenType[]) {TOKEN_LBRACE}))) {
+        j = parse_object(&p, true);
+    } else {
+        parser_expect(&p, TOKEN_LBRACKET, ERROR_UNEXPECTED_TOKEN);
+        j = parse_list(&p, true);
+    }
+
+    // The parser stops in the middle of the input, so its tokens could still hold on to strings.
+    tok_free(&p.curr);
+    tok_free(&p.prev);
+    return j;
+}
+
+/// Parse only the value of `key` from the lazy object at `source`.
+///
+/// Returns `json_invalid()` if the object has no field named `key`.
+Json json_materialize_field(char *source, String key) {
+    Lexer l = lex_init(source);
+
+    Parser p = {
+        .l = &l,
+        .should_free = true,
+    };
+
+    Json value = json_invalid();
+
+    parser_next(&p);
+    parser_expect(&p, TOKEN_LBRACE, ERROR_UNEXPECTED_TOKEN);
+    while (p.curr.type == TOKEN_STRING) {
+        bool found = string_equal(p.curr.inner.string, key);
+
+        // Skip past the key and the colon
+        parser_next(&p);
+        parser_next(&p);
+
+        if (found) {
+            // Keep looking in case the key is repeated, the last one wins like in `json_object_set`
+            json_free(value);
+            value = parse_json(&p, true);
+        } else if (p.curr.type == TOKEN_LBRACE || p.curr.type == TOKEN_LBRACKET) {
+            JsonType inner_type;
+            skip_lazy(&p, &inner_type);
+        } else {
+            skip_json(&p);
+        }
+
+        if (!parser_matches(&p, LIST((TokenType[]) {TOKEN_COMMA}))) {
+            break;
+        }
+    }
+
+    tok_free(&p.curr);
+    tok_free(&p.prev);
+    return value;
+}
+
+/**************************
+ * Projected deserializer *
+ **************************/
+
+/// The type of the value starting at the current token.
+static JsonType token_value_type(Parser *p) {
+    switch (p->curr.type) {
+    case TOKEN_LBRACE:
+        return JSON_TYPE_OBJECT;
+    case TOKEN_LBRACKET:
+        return JSON_TYPE_LIST;
+    case TOKEN_STRING:
+        return JSON_TYPE_STRING;
+    case TOKEN_TRUE:
+    case TOKEN_FALSE:
+        return JSON_TYPE_BOOL;
+    case TOKEN_NULL:
+        return JSON_TYPE_NULL;
+    default:
+        return JSON_TYPE_NUMBER;
+    }
+}
+
+/// Skips over the value at the current token, containers are skipped without lexing them.
+static void skip_value(Parser *p) {
+    if (p->curr.type == TOKEN_LBRACE || p->curr.type == TOKEN_LBRACKET) {
+        JsonType inner_type;
+        skip_lazy(p, &inner_type);
+    } else {
+        skip_json(p);
+    }
+}
+
+static Json parse_projected(Parser *p, Projection *proj);
+
+static Json parse_projected_object(Parser *p, Projection *proj) {
+    Json obj = json_object_sized(proj->fields.length);
+
+    if (p->curr.type != TOKEN_RBRACE) {
+        do {
+            parser_expect(p, TOKEN_STRING, ERROR_EXPECTED_STRING);
+            if (p->error != NULL) {
+                json_free(obj);
+                return json_invalid();
+            }
+
+            // Keep the key alive past the next token, the parser would free it otherwise.
+            Token key = p->prev;
+            tok_take_string(&p->prev);
+
+            parser_expect(p, TOKEN_COLON, ERROR_EXPECTED_COLON);
+            if (p->error != NULL) {
+                tok_free(&key);
+                json_free(obj);
+                return json_invalid();
+            }
+
+            Projection *field = projection_find_field(proj, key.inner.string);
+            if (field == NULL) {
+                tok_free(&key);
+                skip_value(p);
+                continue;
+            }
+
+            Json value = parse_projected(p, field);
+            obj = json_object_set(obj, json_string_from(tok_take_string(&key)), value);
+        } while (parser_matches(p, LIST((TokenType[]) {TOKEN_COMMA})));
+    }
+
+    parser_expect(p, TOKEN_RBRACE, ERROR_MISSING_RBRACE);
+    if (p->error != NULL) {
+        json_free(obj);
+        return json_invalid();
+    }
+
+    return obj;
+}
+
+static Json parse_projected_list(Parser *p, Projection *proj) {
+    Json j = json_list();
+    JsonType inner = JSON_TYPE_INVALID;
+
+    if (p->curr.type != TOKEN_RBRACKET) {
+        do {
+            // Elements that aren't needed are still kept as nulls, so that the length and
+            // the indices of the list stay the same.
+            JsonType t = token_value_type(p);
+            inner = (inner == JSON_TYPE_INVALID || inner == t) ? t : JSON_TYPE_ANY;
+
+            if (proj->elements == NULL) {
+                skip_value(p);
+                j = json_list_append(j, json_null());
+            } else {
+                j = json_list_append(j, parse_projected(p, proj->elements));
+            }
+        } while (parser_matches(p, LIST((TokenType[]) {TOKEN_COMMA})));
+    }
+
+    parser_expect(p, TOKEN_RBRACKET, ERROR_MISSING_RBRACKET);
+    if (p->error != NULL) {
+        json_free(j);
+        return json_invalid();
+    }
+
+    json_list_set_inner_type(j, inner);
+    return j;
+}
+
+/// Parses the parts of the value at the current token that are in `proj`.
+static Json parse_projected(Parser *p, Projection *proj) {
+    if (proj->whole) {
+        return parse_json(p, false);
+    }
+
+    if (parser_matches(p, LIST((TokenType[]) {TOKEN_LBRACE}))) {
+        // Iterating over an object reads all of its fields
+        if (proj->elements != NULL) {
+            return parse_object(p, false);
+        }
+        return parse_projected_object(p, proj);
+    }
+
+    if (parser_matches(p, LIST((TokenType[]) {TOKEN_LBRACKET}))) {
+        return parse_projected_list(p, proj);
+    }
+
+    return parse_json(p, false);
+}
+
+/// Deserialize only the parts of `str` that are in `projection`.
+///
+/// Fields of objects that aren't part of the projection are left out, and list elements that
+/// aren't part of it are replaced with nulls. Lists and objects that are left out are skipped
+/// by matching brackets and quotes, so errors inside of them are not reported.
+///
+/// The result borrows from `str`, so `str` must outlive it.
+DeserializeResult json_deserialize_projected(char *str, Projection *projection) {
+    Lexer l = lex_init(str);
+
+    Parser p = {
+        .l = &l,
+        .should_free = true,
+    };
+
+    parser_next(&p);
+    Json j = parse_projected(&p, projection);
     parser_expect(&p, TOKEN_EOF, ERROR_EXPECTED_EOF);
     if (p.error != NULL) {
-        tok_free(&p.curr);
-        tok_free(&p.prev);
         json_free(j);
-        return (DeserializeResult) {
-            .err = jrq_error(p.curr.range, "%s", p.error),
-            .type = RES_ERR,
-        };
+        return deserialize_error(&p);
+    }
+
+    return (DeserializeResult) {.result = j};
+}
+
+/*************************
+ * Parallel deserializer *
+ *************************/
+
+/// Inputs smaller than this are parsed sequentially, spawning threads isn't worth it for them.
+#define PARALLEL_MIN_SIZE (1 << 20)
+
+typedef Vec(char *) Boundaries;
+
+/// A run of consecutive elements of the top level list that is parsed by one thread.
+struct parse_chunk {
+    /// First character of the first element in the chunk
+    char *start;
+    /// The `,` or `]` after the last element in the chunk. This is temporarily replaced with a
+    /// '\0' while the chunk is being parsed so that the lexer stops there.
+    char *end;
+
+    /// List of the elements in the chunk, only valid if `failed` is false.
+    Json result;
+    bool failed;
+};
+
+/// Structural pre-scan of a top level list.
+///
+/// This walks the input without lexing or building anything, only keeping track of strings and
+/// bracket depth. The position of every comma separating two top level elements is appended to
+/// `boundaries`, followed by the position of the list's closing `]`.
+///
+/// Returns false if the input is not a single list or if its strings/brackets are unbalanced.
+static bool scan_list_boundaries(char *str, Boundaries *boundaries) {
+    while (is_json_whitespace(*str)) {
+        str++;
+    }
+    if (*str != '[') {
+        return false;
+    }
+
+    int depth = 0;
+    for (char *c = str; *c != '\0'; c++) {
+        switch (*c) {
+        case '"':
+            for (c++; *c != '"'; c++) {
+                if (*c == '\0' || (*c == '\\' && *++c == '\0')) {
+                    return false;
+                }
+            }
+            break;
+        case '[':
+        case '{':
+            depth++;
+            break;
+        case ']':
+        case '}':
+            if (--depth != 0) {
+                break;
+            }
+            if (*c != ']') {
+                return false;
+            }
+            vec_append(*boundaries, c);
+
+            // Only whitespace is allowed after the list
+            for (c++; is_json_whitespace(*c); c++) {
+            }
+            return *c == '\0';
+        case ',':
+            if (depth == 1) {
+                vec_append(*boundaries, c);
+            }
+            break;
+        }
+    }
+
+    return false;
+}
+
+/// Parses the comma separated elements of a single chunk into a list.
+static void *parse_chunk(void *aux) {
+    struct parse_chunk *c = aux;
+
+    Lexer l = lex_init(c->start);
+    Parser p = {
+        .l = &l,
+        .should_free = true,
+    };
+
+    Json list = json_list();
+
+    parser_next(&p);
+    do {
+        list = json_list_append(list, parse_json(&p, false));
+    } while (parser_matches(&p, LIST((TokenType[]) {TOKEN_COMMA})));
+    parser_expect(&p, TOKEN_EOF, ERROR_EXPECTED_EOF);
+
+    if (p.error != NULL) {
+        json_free(list);
+        c->failed = true;
+    } else {
+        c->result = list;
+    }
+
+    json_pool_release();
+    return NULL;
+}
+
+/// Deserialize `str` using up to `threads` threads.
+///
+/// When `str` is a large top level list, the elements of the list are split into chunks of roughly
+/// equal size that are parsed concurrently and then stitched together into one list. Anything else
+/// is handed to `json_deserialize`.
+///
+/// The result is always the same as `json_deserialize` would produce: if any chunk fails to parse,
+/// the whole input is parsed again sequentially so that the error matches exactly.
+///
+/// If `threads` is 0, one thread per online CPU is used.
+DeserializeResult json_deserialize_parallel(char *str, uint threads) {
+    if (threads == 0) {
+        // sysconf gives -1 when the amount of CPUs can't be found
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 1 ? cpus : 1;
+    }
+
+    size_t length = strlen(str);
+    if (threads < 2 || length < PARALLEL_MIN_SIZE) {
+        return json_deserialize(str);
+    }
+
+    Boundaries boundaries = {0};
+    if (!scan_list_boundaries(str, &boundaries) || boundaries.length < threads) {
+        jrq_free(boundaries.data);
+        return json_deserialize(str);
+    }
+
+    char *open = strchr(str, '[');
+    char *close = boundaries.data[boundaries.length - 1];
+
+    // Split the elements into chunks with roughly the same amount of bytes in each.
+    struct parse_chunk *chunks = jrq_calloc(threads, sizeof(*chunks));
+    uint chunk_amt = 0;
+    char *start = open + 1;
+    for (size_t i = 0; i < boundaries.length; i++) {
+        char *end = boundaries.data[i];
+        size_t target = (close - open) * (chunk_amt + 1) / threads;
+
+        if (end == close || end - open >= target) {
+            chunks[chunk_amt++] = (struct parse_chunk) {.start = start, .end = end};
+            start = end + 1;
+        }
+    }
+    jrq_free(boundaries.data);
+
+    pthread_t *handles = jrq_calloc(chunk_amt, sizeof(*handles));
+    bool *spawned = jrq_calloc(chunk_amt, sizeof(*spawned));
+
+    // The boundaries are never part of an element, so it is fine to overwrite them while parsing.
+    for (uint i = 0; i < chunk_amt; i++) {
+        *chunks[i].end = '\0';
+    }
+    for (uint i = 0; i < chunk_amt; i++) {
+        spawned[i] = pthread_create(&handles[i], NULL, &parse_chunk, &chunks[i]) == 0;
+        if (!spawned[i]) {
+            parse_chunk(&chunks[i]);
+        }
+    }
+
+    bool failed = false;
+    for (uint i = 0; i < chunk_amt; i++) {
+        if (spawned[i]) {
+            pthread_join(handles[i], NULL);
+        }
+        *chunks[i].end = (i + 1 == chunk_amt) ? ']' : ',';
+        failed = failed || chunks[i].failed;
+    }
+    jrq_free(handles);
+    jrq_free(spawned);
+
+    if (failed) {
+        for (uint i = 0; i < chunk_amt; i++) {
+            if (!chunks[i].failed) {
+                json_free(chunks[i].result);
+            }
+        }
+        jrq_free(chunks);
+        return json_deserialize(str);
+    }
+
+    size_t total = 0;
+    for (uint i = 0; i < chunk_amt; i++) {
+        total += json_list_length(chunks[i].result);
+    }
+
+    Json j = json_list_sized(total);
+    for (uint i = 0; i < chunk_amt; i++) {
+        JsonList *elements = json_get_list(chunks[i].result);
+        for (size_t k = 0; k < elements->length; k++) {
+            j = json_list_append(j, elements->data[k]);
+        }
+
+        // The elements were moved into `j`, so only free the chunk's list itself.
+        elements->length = 0;
+        json_free(chunks[i].result);
     }
+    jrq_free(chunks);
 
     return (DeserializeResult) {.result = j};
 }
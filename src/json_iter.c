@@ -1,11 +1,19 @@
 #include "json_iter.h"
 #include "src/alloc.h"
 #include "src/json.h"
+#include "src/json_table.h"
 #include "src/strings.h"
+#include "src/vector.h"
 #include <assert.h>
+#include <math.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #define NEXT(iter)                                                                                 \
     ({                                                                                             \
@@ -33,6 +41,9 @@ typedef void (*FreeFunc)(JsonIterator);
 
 /// A SizeHintFunc is the function that gets called every time `iter_size_hint`
 /// is called.
+///
+/// The hint is the exact amount of elements left, or 0 when it isn't known. Collecting reserves
+/// that many elements up front, so iterators that may drop elements must not pass a hint through.
 typedef size_t (*SizeHintFunc)(JsonIterator);
 
 /// Base "class" for an iterator.
@@ -74,7 +85,7 @@ void iter_free(JsonIterator i) {
     if (i->free != NULL) {
         i->free(i);
     }
-    free(i);
+    jrq_free(i);
 }
 
 size_t iter_size_hint(JsonIterator i) {
@@ -96,7 +107,7 @@ static size_t size_hint_json(JsonIterator _i) {
         Json data;
     } *i = (typeof(i))_i;
 
-    switch (i->data.type) {
+    switch (json_get_type(i->data)) {
     case JSON_TYPE_OBJECT:
         return json_object_length(i->data);
     case JSON_TYPE_STRING:
@@ -152,7 +163,7 @@ static void free_func_next_and_captures(JsonIterator _i) {
     } *i = (typeof(i))_i;
 
     iter_free(i->iter);
-    free(i->closure_captures);
+    jrq_free(i->closure_captures);
 }
 
 #define JSON_DATA_ITERATOR(STRUCT_NAME, CREATE_FUNC_NAME, NEXT_FUNC_NAME)                          \
@@ -344,7 +355,7 @@ JsonIterator iter_filter(JsonIterator iter, FilterFunc func, void *captures, boo
         .base = { 
             .func = &filter_iter_next,
             .free = free_captures ? &free_func_next_and_captures : &free_func_next,
-            .size_hint = &size_hint_next,
+            .size_hint = &size_hint_unknown,
         },
         .iter = iter,
         .filter_func = func,
@@ -437,7 +448,7 @@ JsonIterator iter_take_while(JsonIterator iter, FilterFunc F, void *captures, bo
         .base = { 
             .func = &take_while_iter_next,
             .free = free_captures ? &free_func_next_and_captures : &free_func_next,
-            .size_hint = &size_hint_next,
+            .size_hint = &size_hint_unknown,
         },
         .iter = iter,
         .filter_func = F,
@@ -462,7 +473,7 @@ JsonIterator iter_skip_while(JsonIterator iter, FilterFunc F, void *captures, bo
         .base = { 
             .func = &skip_while_iter_next,
             .free = free_captures ? &free_func_next_and_captures : &free_func_next,
-            .size_hint = &size_hint_next,
+            .size_hint = &size_hint_unknown,
         },
         .iter = iter,
         .filter_func = F,
@@ -537,6 +548,112 @@ Json iter_collect(JsonIterator i) {
     return list;
 }
 
+/*********
+ * Top k *
+ *********/
+
+typedef struct {
+    Json key;
+    Json value;
+    /// Where the element was in the iterator, equal keys are kept in this order.
+    size_t position;
+} HeapItem;
+
+/// Whether `a` comes before `b` in the result of `iter_top_k`.
+static bool heap_before(const HeapItem *a, const HeapItem *b, bool largest) {
+    int cmp = json_compare(a->key, b->key);
+    if (largest) {
+        cmp = -cmp;
+    }
+    return cmp < 0 || (cmp == 0 && a->position < b->position);
+}
+
+/// Moves the item at `i` down until it comes after neither of its children.
+static void heap_sift_down(HeapItem *heap, size_t length, size_t i, bool largest) {
+    for (;;) {
+        size_t last = i;
+        for (size_t child = 2 * i + 1; child <= 2 * i + 2 && child < length; child++) {
+            if (heap_before(&heap[last], &heap[child], largest)) {
+                last = child;
+            }
+        }
+        if (last == i) {
+            return;
+        }
+        HeapItem swap = heap[i];
+        heap[i] = heap[last];
+        heap[last] = swap;
+        i = last;
+    }
+}
+
+/// Moves the item at `i` up until its parent doesn't come before it.
+static void heap_sift_up(HeapItem *heap, size_t i, bool largest) {
+    while (i > 0 && heap_before(&heap[(i - 1) / 2], &heap[i], largest)) {
+        HeapItem swap = heap[i];
+        heap[i] = heap[(i - 1) / 2];
+        heap[(i - 1) / 2] = swap;
+        i = (i - 1) / 2;
+    }
+}
+
+/// Collect the `k` elements of `iter` with the smallest keys into a list, or with the largest if
+/// `largest` is set. The list is in the same order sorting every element by its key and taking the
+/// first `k` would give, but only `k` elements are kept at a time.
+///
+/// The key of an element is what `key_func` returns for it, or the element itself if `key_func` is
+/// NULL.
+Json iter_top_k(
+    JsonIterator iter,
+    size_t k,
+    Json (*key_func)(Json, void *),
+    void *captures,
+    bool largest
+) {
+    // A heap with the item that comes last at the top, which is the one to drop when a better one
+    // comes along. It grows as it's filled, so a huge `k` doesn't allocate room it won't use.
+    Vec(HeapItem) heap = {0};
+
+    size_t position = 0;
+    for (IterOption o = iter_next(iter); o.type == ITER_SOME; o = iter_next(iter)) {
+        HeapItem item = {
+            .key = key_func == NULL ? json_copy(o.some) : key_func(json_copy(o.some), captures),
+            .value = o.some,
+            .position = position++,
+        };
+
+        if (heap.length < k) {
+            vec_append(heap, item);
+            heap_sift_up(heap.data, heap.length - 1, largest);
+        } else if (k > 0 && heap_before(&item, &heap.data[0], largest)) {
+            json_free(heap.data[0].key);
+            json_free(heap.data[0].value);
+            heap.data[0] = item;
+            heap_sift_down(heap.data, heap.length, 0, largest);
+        } else {
+            json_free(item.key);
+            json_free(item.value);
+        }
+    }
+    iter_free(iter);
+
+    // Taking the last item off the heap until it's empty puts them in order from the back
+    for (size_t end = heap.length; end > 1; end--) {
+        HeapItem swap = heap.data[0];
+        heap.data[0] = heap.data[end - 1];
+        heap.data[end - 1] = swap;
+        heap_sift_down(heap.data, end - 1, 0, largest);
+    }
+
+    Json list = json_list_sized(heap.length);
+    for (size_t i = 0; i < heap.length; i++) {
+        json_free(heap.data[i].key);
+        list = json_list_append(list, heap.data[i].value);
+    }
+    jrq_free(heap.data);
+    return list;
+}
+
 /***********
  * ZipIter *
  ***********/
@@ -631,11 +748,33 @@ static IterOption skip_iter_next(JsonIterator _i) {
     return iter_some(NEXT(i->iter));
 }
 
+/// At most N elements are left, which keeps `range(0, 1000000000).take(5).collect()` from
+/// allocating room for all of the range.
+static size_t size_hint_take(JsonIterator _i) {
+    SkipTakeIter *i = (SkipTakeIter *)_i;
+
+    size_t inner = iter_size_hint(i->iter);
+    if (i->N <= 0) {
+        return 0;
+    }
+    return inner < (size_t)i->N ? inner : (size_t)i->N;
+}
+
+static size_t size_hint_skip(JsonIterator _i) {
+    SkipTakeIter *i = (SkipTakeIter *)_i;
+
+    size_t inner = iter_size_hint(i->iter);
+    if (i->N <= 0) {
+        return inner;
+    }
+    return inner > (size_t)i->N ? inner - i->N : 0;
+}
+
 JsonIterator iter_take(JsonIterator _i, int N) {
     SkipTakeIter *i = jrq_malloc(sizeof(*i));
 
     *i = (SkipTakeIter) {
-        .base = {.func = &take_iter_next, .free = &free_func_next, .size_hint = &size_hint_next},
+        .base = {.func = &take_iter_next, .free = &free_func_next, .size_hint = &size_hint_take},
         .iter = _i,
         .N = N,
     };
@@ -647,7 +786,7 @@ JsonIterator iter_skip(JsonIterator _i, int N) {
     SkipTakeIter *i = jrq_malloc(sizeof(*i));
 
     *i = (SkipTakeIter) {
-        .base = {.func = &skip_iter_next, .free = &free_func_next, .size_hint = &size_hint_next},
+        .base = {.func = &skip_iter_next, .free = &free_func_next, .size_hint = &size_hint_skip},
         .iter = _i,
         .N = N,
     };
@@ -671,35 +810,64 @@ static void free_func_split(JsonIterator _i) {
     json_free(i->string);
     json_free(i->splitter);
 }
+/// Finds the first occurrence of the `length` bytes of `sep` in `[c, end)`, returns NULL if there
+/// is none. `length` must be at least 1.
+static const char *find_separator(const char *c, const char *end, const char *sep, size_t length) {
+    if (length == 1) {
+        return memchr(c, sep[0], end - c);
+    }
+
+    // Only the places where both the first and the last byte match are compared in full, which
+    // skips over almost everything for separators that aren't made of one repeated byte.
+    size_t last = length - 1;
+#ifdef __SSE2__
+    const __m128i first_byte = _mm_set1_epi8(sep[0]);
+    const __m128i last_byte = _mm_set1_epi8(sep[last]);
+
+    for (; (size_t)(end - c) >= last + 16; c += 16) {
+        __m128i firsts = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)c), first_byte);
+        __m128i lasts = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(c + last)), last_byte);
+        int mask = _mm_movemask_epi8(_mm_and_si128(firsts, lasts));
+        for (; mask != 0; mask &= mask - 1) {
+            int i = __builtin_ctz(mask);
+            if (last == 1 || memcmp(c + i + 1, sep + 1, last - 1) == 0) {
+                return c + i;
+            }
+        }
+    }
+#endif
+
+    for (; (size_t)(end - c) >= length; c++) {
+        if (c[0] == sep[0] && c[last] == sep[last] && memcmp(c + 1, sep + 1, last - 1) == 0) {
+            return c;
+        }
+    }
+    return NULL;
+}
+
 static IterOption split_iter_next(JsonIterator _i) {
     SplitIter *iter = (SplitIter *)_i;
 
     String *str = json_get_string(iter->string);
     String *splitter = json_get_string(iter->splitter);
 
-    uint start = iter->offset;
+    size_t start = iter->offset;
     if (start >= str->length) {
         return iter_done();
     }
 
-    uint splitter_i = 0;
-    while (iter->offset < str->length) {
-        if (string_get(splitter)[splitter_i] == string_get(str)[iter->offset]) {
-            splitter_i += 1;
-        } else {
-            splitter_i = 0;
-        }
-
-        if (splitter_i == splitter->length) {
-            return iter_some(
-                json_substring(iter->string, start, iter->offset++ - start - splitter_i)
-            );
-        }
-
+    // Splitting by an empty string yields every byte on its own
+    if (splitter->length == 0) {
         iter->offset++;
+        return iter_some(json_substring(iter->string, start, 1));
     }
 
-    return iter_some(json_substring(iter->string, start, iter->offset++ - start - splitter_i - 1));
+    const char *match = find_separator(
+        str->data + start, str->data + str->length, splitter->data, splitter->length
+    );
+    size_t end = match != NULL ? (size_t)(match - str->data) : str->length;
+    iter->offset = match != NULL ? end + splitter->length : str->length;
+    return iter_some(json_substring(iter->string, start, end - start));
 }
 
 /// Splits a string and yields each substring
@@ -718,6 +886,270 @@ JsonIterator iter_split(Json string, Json splitter) {
     return (JsonIterator)i;
 };
 
+/**************
+ * UniqueIter *
+ **************/
+
+/// An iterator that yields the elements of `iter` whose key it hasn't seen before.
+typedef struct {
+    struct JsonIterator base;
+    JsonIterator iter;
+
+    /// Extra state to be passed into `key_func` when it's called
+    void *closure_captures;
+    bool free_captures;
+
+    /// Gives the key of an element, or NULL when elements are their own key
+    MapFunc key_func;
+
+    /// The keys seen so far, only the keys are used
+    JsonTable seen;
+} UniqueIter;
+
+static void free_func_unique(JsonIterator _i) {
+    UniqueIter *i = (UniqueIter *)_i;
+    iter_free(i->iter);
+    if (i->free_captures) {
+        jrq_free(i->closure_captures);
+    }
+    json_table_free(&i->seen);
+}
+
+static IterOption unique_iter_next(JsonIterator _i) {
+    UniqueIter *i = (UniqueIter *)_i;
+
+    for (;;) {
+        Json j = NEXT(i->iter);
+        Json key = i->key_func != NULL ? i->key_func(json_copy(j), i->closure_captures)
+                                       : json_copy(j);
+
+        bool added;
+        json_table_entry(&i->seen, key, &added);
+        if (added) {
+            return iter_some(j);
+        }
+        json_free(j);
+    }
+}
+
+/// An iterator that yields the first element of `iter` for every key, where the key of an element
+/// is what `func` returns for it. Without `func` elements are their own key.
+///
+/// Elements are yielded as soon as they're seen, and only the distinct keys are kept around.
+JsonIterator iter_unique(JsonIterator iter, MapFunc func, void *captures, bool free_captures) {
+    UniqueIter *i = jrq_malloc(sizeof(*i));
+
+    *i = (UniqueIter) {
+        .base = {
+            .func = &unique_iter_next,
+            .free = &free_func_unique,
+            .size_hint = &size_hint_unknown,
+        },
+        .iter = iter,
+        .closure_captures = captures,
+        .free_captures = free_captures,
+        .key_func = func,
+    };
+
+    return (JsonIterator)i;
+}
+
+/************
+ * JoinIter *
+ ************/
+
+#define NO_ENTRY SIZE_MAX
+
+typedef struct {
+    struct JsonIterator base;
+
+    /// The elements of the side the table isn't built over, which are looked up in it as they come
+    JsonIterator probe;
+    MapFunc probe_key;
+    void *probe_captures;
+
+    /// The other side, which the table is built from before the first pair is yielded
+    Json build;
+    MapFunc build_key;
+    void *build_captures;
+    bool built;
+
+    bool free_captures;
+    /// Whether the probed elements are the left side of the pairs
+    bool probe_is_left;
+    /// Whether left elements without a match are yielded as `[left, null]`
+    bool keep_unmatched;
+
+    /// From the key of every built element to the list of built elements with that key
+    JsonTable table;
+    /// Which entries of the table have been matched, only kept when the table is over the left
+    /// side of a left join. Those that weren't are yielded once `draining`.
+    bool *matched;
+    bool draining;
+
+    /// The probed element whose matches are being yielded, and the entry of its matches
+    Json current;
+    bool has_current;
+    size_t entry;
+    size_t match;
+} JoinIter;
+
+static void free_func_join(JsonIterator _i) {
+    JoinIter *i = (JoinIter *)_i;
+    iter_free(i->probe);
+    json_free(i->build);
+    if (i->free_captures) {
+        jrq_free(i->probe_captures);
+        jrq_free(i->build_captures);
+    }
+    json_table_free(&i->table);
+    jrq_free(i->matched);
+    if (i->has_current) {
+        json_free(i->current);
+    }
+}
+
+static void join_build(JoinIter *i) {
+    JsonList *elements = json_get_list(i->build);
+    for (size_t k = 0; k < elements->length; k++) {
+        Json element = json_copy(elements->data[k]);
+        Json key = i->build_key(json_copy(element), i->build_captures);
+
+        bool added;
+        JsonTableEntry *entry = json_table_entry(&i->table, key, &added);
+        entry->value = json_list_append(added ? json_list_sized(1) : entry->value, element);
+    }
+    json_free(i->build);
+    i->build = json_null();
+    i->built = true;
+
+    if (i->keep_unmatched && !i->probe_is_left) {
+        i->matched = jrq_calloc(i->table.entries.length + 1, sizeof(*i->matched));
+    }
+}
+
+/// The pair of a probed and a built element, in the order of the sides they're from.
+static Json join_pair(JoinIter *i, Json probed, Json built) {
+    Json pair = json_list_sized(2);
+    pair = json_list_append(pair, i->probe_is_left ? probed : built);
+    return json_list_append(pair, i->probe_is_left ? built : probed);
+}
+
+static IterOption join_iter_next(JsonIterator _i) {
+    JoinIter *i = (JoinIter *)_i;
+    if (!i->built) {
+        join_build(i);
+    }
+
+    for (;;) {
+        if (i->has_current) {
+            if (i->entry != NO_ENTRY) {
+                Json matches = i->table.entries.data[i->entry].value;
+                if (i->match < json_list_length(matches)) {
+                    Json match = json_copy(json_list_get(matches, i->match++));
+                    return iter_some(join_pair(i, json_copy(i->current), match));
+                }
+            } else if (i->keep_unmatched && i->probe_is_left) {
+                i->has_current = false;
+                return iter_some(join_pair(i, i->current, json_null()));
+            }
+            json_free(i->current);
+            i->has_current = false;
+        }
+
+        IterOption o = iter_next(i->probe);
+        if (o.type == ITER_DONE) {
+            break;
+        }
+        Json key = i->probe_key(json_copy(o.some), i->probe_captures);
+        JsonTableEntry *entry = json_table_get(&i->table, key);
+        json_free(key);
+
+        i->current = o.some;
+        i->has_current = true;
+        i->entry = entry == NULL ? NO_ENTRY : (size_t)(entry - i->table.entries.data);
+        i->match = 0;
+        if (entry != NULL && i->matched != NULL) {
+            i->matched[i->entry] = true;
+        }
+    }
+
+    // When the table is over the left side of a left join, the left elements that weren't matched
+    // come after all the pairs, in the order their keys first showed up in.
+    if (i->matched == NULL) {
+        return iter_done();
+    }
+    if (!i->draining) {
+        i->draining = true;
+        i->entry = 0;
+        i->match = 0;
+    }
+    for (; i->entry < i->table.entries.length; i->entry++, i->match = 0) {
+        Json unmatched = i->table.entries.data[i->entry].value;
+        if (!i->matched[i->entry] && i->match < json_list_length(unmatched)) {
+            Json left = json_copy(json_list_get(unmatched, i->match++));
+            return iter_some(join_pair(i, json_null(), left));
+        }
+    }
+    return iter_done();
+}
+
+/// An iterator of the pairs `[l, r]` of an element of `left` and an element of `right` with equal
+/// keys, where `left_key` and `right_key` give the keys of the elements of each side. With
+/// `keep_unmatched` every element of `left` without a match is also yielded, as `[l, null]`.
+///
+/// A hash table is built over the smaller side, and the elements of the other side are looked up
+/// in it as they're streamed. The pairs come in the order of the streamed side, which is `left`
+/// unless it's known to be the smaller one.
+JsonIterator iter_join(
+    JsonIterator left,
+    Json right,
+    MapFunc left_key,
+    void *left_captures,
+    MapFunc right_key,
+    void *right_captures,
+    bool free_captures,
+    bool keep_unmatched
+) {
+    JoinIter *i = jrq_malloc(sizeof(*i));
+
+    *i = (JoinIter) {
+        .base = {
+            .func = &join_iter_next,
+            .free = &free_func_join,
+            .size_hint = &size_hint_unknown,
+        },
+        .probe = left,
+        .probe_key = left_key,
+        .probe_captures = left_captures,
+        .build = right,
+        .build_key = right_key,
+        .build_captures = right_captures,
+        .free_captures = free_captures,
+        .probe_is_left = true,
+        .keep_unmatched = keep_unmatched,
+    };
+
+    // A size hint of 0 is also what iterators that don't know their size give
+    size_t left_length = iter_size_hint(left);
+    if (left_length != 0 && left_length < json_list_length(right)) {
+        *i = (JoinIter) {
+            .base = i->base,
+            .probe = iter_list(right),
+            .probe_key = right_key,
+            .probe_captures = right_captures,
+            .build = iter_collect(left),
+            .build_key = left_key,
+            .build_captures = left_captures,
+            .free_captures = free_captures,
+            .probe_is_left = false,
+            .keep_unmatched = keep_unmatched,
+        };
+    }
+
+    return (JsonIterator)i;
+}
+
 /*************
  * ChainIter *
  *************/
@@ -770,3 +1202,52 @@ JsonIterator iter_chain(JsonIterator first, JsonIterator second) {
     };
     return (JsonIterator)i;
 };
+
+/*************
+ * RangeIter *
+ *************/
+
+typedef struct {
+    struct JsonIterator base;
+    double start;
+    double step;
+
+    /// Index of the next number, which is `start + index * step`
+    size_t index;
+    size_t length;
+} RangeIter;
+
+static IterOption range_iter_next(JsonIterator _i) {
+    RangeIter *i = (RangeIter *)_i;
+
+    if (i->index >= i->length) {
+        return iter_done();
+    }
+    // Multiplying instead of adding `step` each time keeps fractional steps from drifting
+    return iter_some(json_number(i->start + (double)i->index++ * i->step));
+}
+
+static size_t size_hint_range(JsonIterator _i) {
+    RangeIter *i = (RangeIter *)_i;
+
+    return i->length - i->index;
+}
+
+/// Yields the numbers from `start` up to, but not including, `end`, `step` apart.
+///
+/// The numbers are made when they are asked for, so a range never takes up more memory than a
+/// single number no matter how long it is. `step` must not be 0, a negative `step` counts down.
+JsonIterator iter_range(double start, double end, double step) {
+    assert(step != 0);
+
+    double length = ceil((end - start) / step);
+    RangeIter *i = jrq_malloc(sizeof(*i));
+    *i = (RangeIter) {
+        .base = {.func = &range_iter_next, .free = NULL, .size_hint = &size_hint_range},
+        .start = start,
+        .step = step,
+        .index = 0,
+        .length = !(length > 0) ? 0 : length >= (double)SIZE_MAX ? SIZE_MAX : (size_t)length,
+    };
+    return (JsonIterator)i;
+}
@@ -31,6 +31,13 @@ JsonIterator iter_filter(
 JsonIterator iter_enumerate(JsonIterator iter);
 JsonIterator iter_zip(JsonIterator a, JsonIterator b);
 Json iter_collect(JsonIterator iter);
+Json iter_top_k(
+    JsonIterator iter,
+    size_t k,
+    Json (*key_func)(Json, void *),
+    void *captures,
+    bool largest
+);
 
 JsonIterator iter_skip_while(
     JsonIterator iter,
@@ -48,7 +55,26 @@ JsonIterator iter_take_while(
 JsonIterator iter_skip(JsonIterator, int);
 JsonIterator iter_take(JsonIterator, int);
 
+JsonIterator iter_unique(
+    JsonIterator iter,
+    Json (*key_func)(Json, void *),
+    void *captures,
+    bool free_captures
+);
+
+JsonIterator iter_join(
+    JsonIterator left,
+    Json right,
+    Json (*left_key)(Json, void *),
+    void *left_captures,
+    Json (*right_key)(Json, void *),
+    void *right_captures,
+    bool free_captures,
+    bool keep_unmatched
+);
+
 JsonIterator iter_split(Json, Json);
 JsonIterator iter_chain(JsonIterator first, JsonIterator second);
+JsonIterator iter_range(double start, double end, double step);
 
 #endif // _JSON_ITER_H
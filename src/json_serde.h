@@ -3,11 +3,20 @@
 
 #include "src/errors.h"
 #include "src/json.h"
+#include "src/projection.h"
+#include <stdio.h>
 
 typedef enum {
     JSON_FLAG_TAB = 1,
     JSON_FLAG_COLORS = 2,
     JSON_FLAG_SPACES = 4,
+    /// Escape everything that isn't ascii as `\uXXXX`
+    JSON_FLAG_ASCII = 8,
+    /// Write a string that's being output by itself without quotes or escapes
+    JSON_FLAG_RAW = 16,
+    /// Write each element of a list that's being output on its own line, every line ends with a
+    /// newline. Lines are never tabbed.
+    JSON_FLAG_NDJSON = 32,
 } JsonSerializeFlags;
 
 typedef struct {
@@ -19,6 +28,13 @@ typedef struct {
 } DeserializeResult;
 
 char *json_serialize(Json *json, JsonSerializeFlags flags);
+size_t json_serialize_to(FILE *out, Json *json, JsonSerializeFlags flags);
 DeserializeResult json_deserialize(char *json);
+DeserializeResult json_deserialize_parallel(char *json, uint threads);
+DeserializeResult json_deserialize_lazy(char *json);
+DeserializeResult json_deserialize_projected(char *json, Projection *projection);
+
+Json json_materialize(char *source);
+Json json_materialize_field(char *source, String key);
 
 #endif // _JSON_SERDE_H
@@ -6,26 +6,64 @@
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 
-#define STRING_COLOR string_from_chars("\x1b[32m")
-#define NUM_COLOR string_from_chars("\x1b[36m")
-#define KEY_COLOR string_from_chars("\x1b[34;1m")
-#define RESET_COLOR string_from_chars("\x1b[0m")
-#define NULL_COLOR string_from_chars("\x1b[90;3m")
-#define BOOL_COLOR string_from_chars("\x1b[31m")
-#define SYMBOL_COLOR string_from_chars("\x1b[97m")
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/// A string whose length is known at compile time, so appending it doesn't need a `strlen`.
+#define TOKEN(str) ((String) {.data = (str), .length = sizeof(str) - 1})
+
+#define SYMBOL_CODE "\x1b[97m"
+#define RESET_CODE "\x1b[0m"
+
+#define STRING_COLOR TOKEN("\x1b[32m")
+#define NUM_COLOR TOKEN("\x1b[36m")
+#define KEY_COLOR TOKEN("\x1b[34;1m")
+#define RESET_COLOR TOKEN(RESET_CODE)
+#define NULL_COLOR TOKEN("\x1b[90;3m")
+#define BOOL_COLOR TOKEN("\x1b[31m")
 
 #define APPEND_COLOR(color)                                                                        \
     if (has_flag(s, JSON_FLAG_COLORS)) {                                                           \
         string_append(&s->inner, color);                                                           \
     }
 
+/// Appends the symbol `str`, the coloured version of it is put together at compile time so that
+/// it's appended all at once.
+#define APPEND_SYMBOL(str)                                                                         \
+    string_append(                                                                                 \
+        &s->inner,                                                                                 \
+        has_flag(s, JSON_FLAG_COLORS) ? TOKEN(SYMBOL_CODE str RESET_CODE) : TOKEN(str)             \
+    )
+
+/// The widest indentation that's appended at once, deeper lines are indented in several appends.
+#define MAX_INDENT 128
+
+/// A newline followed by the indentation of a line.
+static char INDENT[1 + MAX_INDENT] = {'\n', [1 ... MAX_INDENT] = ' '};
+
+/// How much output is buffered before it's written out when serializing to a file.
+#define FLUSH_SIZE (64 * 1024)
+
 typedef struct {
     String inner;
     JsonSerializeFlags flags;
+
+    /// Where the output is written to once enough of it is buffered in `inner`, or NULL if all of
+    /// it is kept in `inner`.
+    FILE *out;
+    /// How much has been written to `out` so far
+    size_t written;
+
+    /// The symbols between items and between keys and values, picked once from the flags
+    String comma;
+    String colon;
 } Serializer;
 
 static void serialize(Serializer *s, Json *json, int depth);
+static void serialize_string(Serializer *s, Json str);
 static void serialize_object(Serializer *s, Json *json, int depth);
 static void serialize_list(Serializer *s, Json *json, int depth);
 
@@ -33,102 +71,254 @@ static bool has_flag(Serializer *s, JsonSerializeFlags flag) {
     return (s->flags & flag) ? true : false;
 }
 
-static void tab(Serializer *s, int depth) {
-    if (has_flag(s, JSON_FLAG_TAB)) {
-        for (int d = 0; d < depth; d++) {
-            string_append(&s->inner, string_from_chars("  "));
-        }
+/// Writes out what's buffered if there's enough of it.
+static void maybe_flush(Serializer *s) {
+    if (s->out != NULL && s->inner.length >= FLUSH_SIZE) {
+        fwrite(s->inner.data, 1, s->inner.length, s->out);
+        s->written += s->inner.length;
+        s->inner.length = 0;
+    }
+}
+
+/// Starts a new line indented `depth` levels deep, when the output is tabbed.
+static void newline(Serializer *s, int depth) {
+    if (!has_flag(s, JSON_FLAG_TAB)) {
+        return;
+    }
+
+    uint width = depth > 0 ? (uint)depth * 2 : 0;
+    uint first = width < MAX_INDENT ? width : MAX_INDENT;
+    string_append(&s->inner, string_from_str(INDENT, 1 + first));
+    for (width -= first; width > 0; width -= first) {
+        first = width < MAX_INDENT ? width : MAX_INDENT;
+        string_append(&s->inner, string_from_str(INDENT + 1, first));
     }
 }
 
 static void serialize_list(Serializer *s, Json *json, int depth) {
     JsonList *list = json_get_list(*json);
     if (list->length == 0) {
-        APPEND_COLOR(SYMBOL_COLOR);
-        string_append(&s->inner, string_from_chars("[]"));
-        APPEND_COLOR(RESET_COLOR);
+        APPEND_SYMBOL("[]");
         return;
     }
-    APPEND_COLOR(SYMBOL_COLOR);
-    string_append(&s->inner, string_from_chars(has_flag(s, JSON_FLAG_TAB) ? "[\n" : "["));
-    APPEND_COLOR(RESET_COLOR);
 
+    APPEND_SYMBOL("[");
     for (int i = 0; i < list->length; i++) {
-
-        tab(s, depth);
-
-        serialize(s, &list->data[i], depth);
-
-        if (i + 1 != list->length) {
-            APPEND_COLOR(SYMBOL_COLOR);
-            string_append(&s->inner, string_from_chars(has_flag(s, JSON_FLAG_SPACES) ? ", " : ","));
-            APPEND_COLOR(RESET_COLOR);
-        }
-        if (has_flag(s, JSON_FLAG_TAB)) {
-            string_append(&s->inner, string_from_chars("\n"));
+        if (i != 0) {
+            string_append(&s->inner, s->comma);
         }
+        newline(s, depth);
+        serialize(s, &list->data[i], depth);
+        maybe_flush(s);
     }
-
-    tab(s, depth - 1);
-    APPEND_COLOR(SYMBOL_COLOR);
-    string_append(&s->inner, string_from_chars("]"));
-    APPEND_COLOR(RESET_COLOR);
+    newline(s, depth - 1);
+    APPEND_SYMBOL("]");
 }
 
 static void serialize_object(Serializer *s, Json *json, int depth) {
     JsonObject *fields = json_get_object(*json);
     if (fields->length == 0) {
-        APPEND_COLOR(SYMBOL_COLOR);
-        string_append(&s->inner, string_from_chars("{}"));
-        APPEND_COLOR(RESET_COLOR);
+        APPEND_SYMBOL("{}");
         return;
     }
-    APPEND_COLOR(SYMBOL_COLOR);
-    string_append(&s->inner, string_from_chars(has_flag(s, JSON_FLAG_TAB) ? "{\n" : "{"));
-    APPEND_COLOR(RESET_COLOR);
 
+    APPEND_SYMBOL("{");
     for (int i = 0; i < fields->length; i++) {
+        if (i != 0) {
+            string_append(&s->inner, s->comma);
+        }
+        newline(s, depth);
 
-        tab(s, depth);
-
-        // serialize object's key
         APPEND_COLOR(KEY_COLOR);
-        string_append(&s->inner, string_from_chars("\""));
-        string_append(&s->inner, *json_get_string(fields->data[i].key));
-        string_append(&s->inner, string_from_chars("\""));
+        serialize_string(s, fields->data[i].key);
         APPEND_COLOR(RESET_COLOR);
 
-        APPEND_COLOR(SYMBOL_COLOR);
-        string_append(&s->inner, string_from_chars(has_flag(s, JSON_FLAG_SPACES) ? ": " : ":"));
-        APPEND_COLOR(RESET_COLOR);
+        string_append(&s->inner, s->colon);
 
         serialize(s, &fields->data[i].value, depth);
+        maybe_flush(s);
+    }
+    newline(s, depth - 1);
+    APPEND_SYMBOL("}");
+}
 
-        if (i + 1 != fields->length) {
-            APPEND_COLOR(SYMBOL_COLOR);
-            string_append(&s->inner, string_from_chars(has_flag(s, JSON_FLAG_SPACES) ? ", " : ","));
-            APPEND_COLOR(RESET_COLOR);
+/// How each byte is written inside of a json string: `0` if it's copied over as is, `u` if it's
+/// written as `\u00XX` and otherwise the character that's written after a backslash.
+static const char ESCAPES[256] = {
+    [0x00 ... 0x1f] = 'u',
+    ['\b'] = 'b',
+    ['\f'] = 'f',
+    ['\n'] = 'n',
+    ['\r'] = 'r',
+    ['\t'] = 't',
+    ['"'] = '"',
+    ['\\'] = '\\',
+};
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+/// Finds the first byte in `[c, end)` that can't be copied over as is. With `ascii` every byte of a
+/// non-ascii character has to be escaped as well.
+static char *find_escape(char *c, char *end, bool ascii) {
+#ifdef __SSE2__
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1f);
+
+    for (; end - c >= 16; c += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)c);
+
+        // Subtracting 0x1f with saturation only leaves zeroes where the byte is below 0x20
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+            _mm_cmpeq_epi8(_mm_subs_epu8(chunk, control), _mm_setzero_si128())
+        );
+        int mask = _mm_movemask_epi8(special);
+        if (ascii) {
+            // The top bit is only set for bytes of non-ascii characters
+            mask |= _mm_movemask_epi8(chunk);
         }
-        if (has_flag(s, JSON_FLAG_TAB)) {
-            string_append(&s->inner, string_from_chars("\n"));
+        if (mask != 0) {
+            return c + __builtin_ctz(mask);
         }
     }
+#endif
+
+    for (; c < end; c++) {
+        unsigned char byte = (unsigned char)*c;
+        if (ESCAPES[byte] != 0 || (ascii && byte >= 0x80)) {
+            break;
+        }
+    }
+    return c;
+}
+
+/// Decodes the utf-8 character at `c`, returns its length or 0 if it isn't valid utf-8.
+static int utf8_decode(char *c, char *end, uint *codepoint) {
+    unsigned char lead = (unsigned char)c[0];
+    int length;
+    uint min;
+    if (lead >= 0xF0 && lead < 0xF5) {
+        length = 4, min = 0x10000, *codepoint = lead & 0x07;
+    } else if (lead >= 0xE0) {
+        length = 3, min = 0x800, *codepoint = lead & 0x0F;
+    } else if (lead >= 0xC0) {
+        length = 2, min = 0x80, *codepoint = lead & 0x1F;
+    } else {
+        return 0;
+    }
+    if (lead >= 0xF5 || end - c < length) {
+        return 0;
+    }
+
+    for (int i = 1; i < length; i++) {
+        unsigned char byte = (unsigned char)c[i];
+        if ((byte & 0xC0) != 0x80) {
+            return 0;
+        }
+        *codepoint = (*codepoint << 6) | (byte & 0x3F);
+    }
+
+    // Overlong encodings and surrogates aren't valid utf-8
+    if (*codepoint < min || *codepoint > 0x10FFFF
+        || (*codepoint >= 0xD800 && *codepoint <= 0xDFFF)) {
+        return 0;
+    }
+    return length;
+}
 
-    tab(s, depth - 1);
-    APPEND_COLOR(SYMBOL_COLOR);
-    string_append(&s->inner, string_from_chars("}"));
-    APPEND_COLOR(RESET_COLOR);
+/// Writes `\uXXXX` for a single utf-16 code unit to `out`.
+static void write_unicode_escape(char *out, uint unit) {
+    out[0] = '\\';
+    out[1] = 'u';
+    out[2] = HEX_DIGITS[(unit >> 12) & 0xF];
+    out[3] = HEX_DIGITS[(unit >> 8) & 0xF];
+    out[4] = HEX_DIGITS[(unit >> 4) & 0xF];
+    out[5] = HEX_DIGITS[unit & 0xF];
+}
+
+/// Escapes the non-ascii character at `c` as one or two (for a surrogate pair) `\uXXXX`s, returns
+/// the amount of bytes of `c` that were escaped. Invalid utf-8 is escaped one byte at a time as
+/// U+FFFD.
+static int escape_non_ascii(Serializer *s, char *c, char *end) {
+    uint codepoint;
+    int length = utf8_decode(c, end, &codepoint);
+    if (length == 0) {
+        codepoint = 0xFFFD;
+        length = 1;
+    }
+
+    char buf[12];
+    if (codepoint < 0x10000) {
+        write_unicode_escape(buf, codepoint);
+        string_append(&s->inner, string_from_str(buf, 6));
+    } else {
+        codepoint -= 0x10000;
+        write_unicode_escape(buf, 0xD800 | (codepoint >> 10));
+        write_unicode_escape(buf + 6, 0xDC00 | (codepoint & 0x3FF));
+        string_append(&s->inner, string_from_str(buf, 12));
+    }
+    return length;
+}
+
+/// Appends `str` as a quoted json string, escaping whatever needs to be escaped.
+static void serialize_string(Serializer *s, Json str) {
+    String *string = json_get_string(str);
+    bool ascii = has_flag(s, JSON_FLAG_ASCII);
+
+    // Reserve enough for the common case of only a few escapes up front
+    string_grow(&s->inner, string->length + 3);
+    string_append(&s->inner, TOKEN("\""));
+
+    // Plain strings came straight from the input without any escapes, so they can be copied over.
+    if (json_string_is_plain(str) && !ascii) {
+        string_append(&s->inner, *string);
+        string_append(&s->inner, TOKEN("\""));
+        return;
+    }
+
+    char *end = string->data + string->length;
+    for (char *c = string->data; c < end;) {
+        // Copy everything up until the next byte that has to be escaped all at once
+        char *run = c;
+        c = find_escape(c, end, ascii);
+        if (c != run) {
+            string_append(&s->inner, string_from_str(run, (uint)(c - run)));
+        }
+        if (c == end) {
+            break;
+        }
+
+        unsigned char byte = (unsigned char)*c;
+        if (byte >= 0x80) {
+            c += escape_non_ascii(s, c, end);
+            continue;
+        }
+
+        char buf[6];
+        if (ESCAPES[byte] == 'u') {
+            write_unicode_escape(buf, byte);
+            string_append(&s->inner, string_from_str(buf, 6));
+        } else {
+            buf[0] = '\\';
+            buf[1] = ESCAPES[byte];
+            string_append(&s->inner, string_from_str(buf, 2));
+        }
+        c++;
+    }
+
+    string_append(&s->inner, TOKEN("\""));
 }
 
 void serialize(Serializer *s, Json *json, int depth) {
-    switch (json->type) {
+    switch (json_get_type(*json)) {
     case JSON_TYPE_INVALID:
         // if (json->inner.invalid != NULL) {
         //     string_append_str(s->inner, "<invalid: ");
         //     string_append_str(s->inner, json->inner.invalid);
         //     string_append_str(s->inner, ">");
         // } else {
-        string_append(&s->inner, string_from_chars("<invalid>"));
+        string_append(&s->inner, TOKEN("<invalid>"));
         // }
         break;
     case JSON_TYPE_LIST:
@@ -137,28 +327,30 @@ void serialize(Serializer *s, Json *json, int depth) {
     case JSON_TYPE_OBJECT:
         serialize_object(s, json, depth + 1);
         break;
-    case JSON_TYPE_NUMBER:
+    case JSON_TYPE_NUMBER: {
         APPEND_COLOR(NUM_COLOR);
 
-        string_printf(&s->inner, "%g", json_get_number(*json));
+        // `%g` is never longer than this, so the number only has to be formatted once
+        char buf[32];
+        int length = snprintf(buf, sizeof(buf), "%g", json_get_number(*json));
+        string_append(&s->inner, string_from_str(buf, (uint)length));
 
         APPEND_COLOR(RESET_COLOR);
         break;
+    }
     case JSON_TYPE_STRING:
         APPEND_COLOR(STRING_COLOR);
-        string_append(&s->inner, string_from_chars("\""));
-        string_append(&s->inner, *json_get_string(*json));
-        string_append(&s->inner, string_from_chars("\""));
+        serialize_string(s, *json);
         APPEND_COLOR(RESET_COLOR);
         break;
     case JSON_TYPE_BOOL:
         APPEND_COLOR(BOOL_COLOR);
-        string_append(&s->inner, string_from_chars(json_get_bool(*json) ? "true" : "false"));
+        string_append(&s->inner, json_get_bool(*json) ? TOKEN("true") : TOKEN("false"));
         APPEND_COLOR(RESET_COLOR);
         break;
     case JSON_TYPE_NULL:
         APPEND_COLOR(NULL_COLOR);
-        string_append(&s->inner, string_from_chars("null"));
+        string_append(&s->inner, TOKEN("null"));
         APPEND_COLOR(RESET_COLOR);
         break;
     case JSON_TYPE_ANY:
@@ -167,12 +359,71 @@ void serialize(Serializer *s, Json *json, int depth) {
     }
 }
 
-char *json_serialize(Json *json, JsonSerializeFlags flags) {
-    Serializer *s = &(Serializer) {
+/// Serializes a value that's being output by itself.
+static void serialize_root(Serializer *s, Json *json) {
+    if (has_flag(s, JSON_FLAG_RAW) && json_get_type(*json) == JSON_TYPE_STRING) {
+        string_append(&s->inner, *json_get_string(*json));
+    } else {
+        serialize(s, json, 0);
+    }
+}
+
+static void serialize_top_level(Serializer *s, Json *json) {
+    if (!has_flag(s, JSON_FLAG_NDJSON)) {
+        serialize_root(s, json);
+        return;
+    }
+
+    if (json_get_type(*json) != JSON_TYPE_LIST) {
+        serialize_root(s, json);
+        string_append(&s->inner, TOKEN("\n"));
+        return;
+    }
+
+    JsonList *list = json_get_list(*json);
+    for (int i = 0; i < list->length; i++) {
+        serialize_root(s, &list->data[i]);
+        string_append(&s->inner, TOKEN("\n"));
+        maybe_flush(s);
+    }
+}
+
+static Serializer serializer_new(JsonSerializeFlags flags, FILE *out) {
+    if (flags & JSON_FLAG_NDJSON) {
+        flags &= ~JSON_FLAG_TAB;
+    }
+
+    Serializer s = {
         .inner = string_from_chars_alloc(""),
         .flags = flags,
+        .out = out,
     };
 
-    serialize(s, json, 0);
-    return s->inner.data;
+    bool spaces = has_flag(&s, JSON_FLAG_SPACES);
+    if (has_flag(&s, JSON_FLAG_COLORS)) {
+        s.comma = spaces ? TOKEN(SYMBOL_CODE ", " RESET_CODE) : TOKEN(SYMBOL_CODE "," RESET_CODE);
+        s.colon = spaces ? TOKEN(SYMBOL_CODE ": " RESET_CODE) : TOKEN(SYMBOL_CODE ":" RESET_CODE);
+    } else {
+        s.comma = spaces ? TOKEN(", ") : TOKEN(",");
+        s.colon = spaces ? TOKEN(": ") : TOKEN(":");
+    }
+    return s;
+}
+
+char *json_serialize(Json *json, JsonSerializeFlags flags) {
+    Serializer s = serializer_new(flags, NULL);
+    serialize_top_level(&s, json);
+    return s.inner.data;
+}
+
+/// Serializes `json` straight into `out`, without keeping all of the output in memory.
+///
+/// Returns the amount of bytes written.
+size_t json_serialize_to(FILE *out, Json *json, JsonSerializeFlags flags) {
+    Serializer s = serializer_new(flags, out);
+    serialize_top_level(&s, json);
+    fwrite(s.inner.data, 1, s.inner.length, out);
+    s.written += s.inner.length;
+    jrq_free(s.inner.data);
+    return s.written;
 }
@@ -0,0 +1,378 @@
+#include "src/json_sort.h"
+#include "src/alloc.h"
+#include "src/json.h"
+#include "src/strings.h"
+#include "src/utils.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+/// Lists with fewer elements than this per thread are sorted on one thread, spawning threads isn't
+/// worth it for them.
+#define PARALLEL_MIN_LENGTH (1 << 16)
+
+/// Runs of this many elements are sorted with an insertion sort before they're merged.
+#define RUN_LENGTH 32
+
+/// Blocks of this many items are sorted completely while they're still in the cache.
+#define BLOCK_LENGTH (1 << 14)
+
+#define INLINE static inline __attribute__((always_inline))
+
+/// What all the keys of a sort are, the comparison is specialized for lists of numbers or strings.
+typedef enum {
+    KEYS_NUMBERS,
+    KEYS_STRINGS,
+    KEYS_ANY,
+} KeyKind;
+
+/// The key of an element and where the element was, which is all that's moved around while
+/// sorting. Keeping this to 16 bytes makes every pass of the merge sort move half as much as it
+/// would with the element itself in here.
+typedef struct {
+    union {
+        double number;
+        const char *string;
+        const Json *json;
+    } key;
+    uint32_t string_length;
+    uint32_t index;
+} SortItem;
+
+INLINE String item_string(const SortItem *item) {
+    return string_from_str((char *)item->key.string, item->string_length);
+}
+
+/// Whether `a` has to come before `b`.
+///
+/// `kind` and `descending` are always constants, so this becomes a single comparison in the sorts
+/// it's inlined into.
+INLINE bool before(const SortItem *a, const SortItem *b, KeyKind kind, bool descending) {
+    if (descending) {
+        const SortItem *tmp = a;
+        a = b;
+        b = tmp;
+    }
+    switch (kind) {
+    case KEYS_NUMBERS:
+        return a->key.number < b->key.number;
+    case KEYS_STRINGS:
+        return string_compare(item_string(a), item_string(b)) < 0;
+    case KEYS_ANY:
+        return json_compare(*a->key.json, *b->key.json) < 0;
+    }
+    unreachable("Invalid key kind");
+    return false;
+}
+
+/// Merges the sorted `left` and `right` into `out`.
+INLINE void merge(
+    const SortItem *left,
+    size_t left_length,
+    const SortItem *right,
+    size_t right_length,
+    SortItem *out,
+    KeyKind kind,
+    bool descending
+) {
+    const SortItem *left_end = left + left_length;
+    const SortItem *right_end = right + right_length;
+    while (left < left_end && right < right_end) {
+        // Only taking from the right when it has to come first keeps equal keys in order
+        bool take_right = before(right, left, kind, descending);
+        *out++ = take_right ? *right : *left;
+        right += take_right;
+        left += !take_right;
+    }
+    memcpy(out, left, (left_end - left) * sizeof(*out));
+    memcpy(out + (left_end - left), right, (right_end - right) * sizeof(*out));
+}
+
+INLINE void insertion_sort(SortItem *items, size_t length, KeyKind kind, bool descending) {
+    for (size_t i = 1; i < length; i++) {
+        SortItem item = items[i];
+        size_t j = i;
+        for (; j > 0 && before(&item, &items[j - 1], kind, descending); j--) {
+            items[j] = items[j - 1];
+        }
+        items[j] = item;
+    }
+}
+
+/// Merges runs of `width` items from `from` into runs twice as long in `to`, and so on until one
+/// run has all the items. Returns where the sorted items ended up, which is `from` or `to`.
+INLINE SortItem *merge_passes(
+    SortItem *from,
+    SortItem *to,
+    size_t length,
+    size_t width,
+    KeyKind kind,
+    bool descending
+) {
+    for (; width < length; width *= 2) {
+        for (size_t start = 0; start < length; start += 2 * width) {
+            size_t mid = length - start < width ? length : start + width;
+            size_t end = length - start < 2 * width ? length : start + 2 * width;
+            merge(from + start, mid - start, from + mid, end - mid, to + start, kind, descending);
+        }
+        SortItem *swap = from;
+        from = to;
+        to = swap;
+    }
+    return from;
+}
+
+/// A stable bottom up merge sort, `tmp` has to have room for `length` items.
+///
+/// Blocks that fit in the cache are sorted completely before they're merged with each other, so
+/// the merges of short runs don't go over the whole list every time.
+INLINE void merge_sort(
+    SortItem *items,
+    SortItem *tmp,
+    size_t length,
+    KeyKind kind,
+    bool descending
+) {
+    for (size_t block = 0; block < length; block += BLOCK_LENGTH) {
+        size_t block_length = length - block < BLOCK_LENGTH ? length - block : BLOCK_LENGTH;
+        for (size_t i = 0; i < block_length; i += RUN_LENGTH) {
+            size_t run = block_length - i < RUN_LENGTH ? block_length - i : RUN_LENGTH;
+            insertion_sort(items + block + i, run, kind, descending);
+        }
+
+        SortItem *sorted = merge_passes(
+            items + block, tmp + block, block_length, RUN_LENGTH, kind, descending
+        );
+        if (sorted != items + block) {
+            memcpy(items + block, sorted, block_length * sizeof(*items));
+        }
+    }
+
+    SortItem *sorted = merge_passes(items, tmp, length, BLOCK_LENGTH, kind, descending);
+    if (sorted != items) {
+        memcpy(items, sorted, length * sizeof(*items));
+    }
+}
+
+// Every kind of key gets its own copy of the sort and merge with the comparison inlined
+#define SPECIALIZE(call, kind, descending)                                                         \
+    switch (kind) {                                                                                \
+    case KEYS_NUMBERS:                                                                             \
+        descending ? call(KEYS_NUMBERS, true) : call(KEYS_NUMBERS, false);                         \
+        break;                                                                                     \
+    case KEYS_STRINGS:                                                                             \
+        descending ? call(KEYS_STRINGS, true) : call(KEYS_STRINGS, false);                         \
+        break;                                                                                     \
+    case KEYS_ANY:                                                                                 \
+        descending ? call(KEYS_ANY, true) : call(KEYS_ANY, false);                                 \
+        break;                                                                                     \
+    }
+
+/// A part of a parallel sort that is done by one thread: sorting `length` items, or merging the
+/// first `left_length` of them with the rest. Either way `tmp` is where they end up when merging.
+struct sort_task {
+    SortItem *items;
+    SortItem *tmp;
+    size_t length;
+    size_t left_length;
+
+    KeyKind kind;
+    bool descending;
+};
+
+static void *sort_task(void *aux) {
+    struct sort_task *t = aux;
+#define CALL(kind, descending) merge_sort(t->items, t->tmp, t->length, kind, descending)
+    SPECIALIZE(CALL, t->kind, t->descending);
+#undef CALL
+    return NULL;
+}
+
+static void *merge_task(void *aux) {
+    struct sort_task *t = aux;
+    SortItem *right = t->items + t->left_length;
+    size_t right_length = t->length - t->left_length;
+#define CALL(kind, descending)                                                                     \
+    merge(t->items, t->left_length, right, right_length, t->tmp, kind, descending)
+    SPECIALIZE(CALL, t->kind, t->descending);
+#undef CALL
+    return NULL;
+}
+
+/// Runs every task on its own thread, or on this one if a thread can't be spawned.
+static void run_tasks(struct sort_task *tasks, size_t amount, void *(*func)(void *)) {
+    pthread_t *handles = jrq_calloc(amount, sizeof(*handles));
+    bool *spawned = jrq_calloc(amount, sizeof(*spawned));
+
+    for (size_t i = 0; i < amount; i++) {
+        // The last task is done by this thread, which would only be waiting otherwise
+        spawned[i] = i + 1 < amount && pthread_create(&handles[i], NULL, func, &tasks[i]) == 0;
+        if (!spawned[i]) {
+            func(&tasks[i]);
+        }
+    }
+    for (size_t i = 0; i < amount; i++) {
+        if (spawned[i]) {
+            pthread_join(handles[i], NULL);
+        }
+    }
+
+    jrq_free(handles);
+    jrq_free(spawned);
+}
+
+/// Sorts `items` in chunks on up to one thread per online CPU, and then merges the chunks in pairs
+/// on as many threads as there are pairs.
+static void sort_parallel(SortItem *items, size_t length, KeyKind kind, bool descending) {
+    // Comparing lazy lists or objects parses them, which can't be done from several threads
+    long cpus = kind == KEYS_ANY ? 1 : sysconf(_SC_NPROCESSORS_ONLN);
+    // sysconf gives -1 when the amount of CPUs can't be found
+    size_t threads = cpus > 1 ? cpus : 1;
+    size_t chunks = 1;
+    while (chunks * 2 <= threads && length / (chunks * 2) >= PARALLEL_MIN_LENGTH) {
+        chunks *= 2;
+    }
+
+    SortItem *tmp = jrq_malloc(length * sizeof(*tmp));
+    struct sort_task *tasks = jrq_calloc(chunks, sizeof(*tasks));
+#define BOUND(chunk) (length * (chunk) / chunks)
+
+    for (size_t i = 0; i < chunks; i++) {
+        tasks[i] = (struct sort_task) {
+            .items = items + BOUND(i),
+            .tmp = tmp + BOUND(i),
+            .length = BOUND(i + 1) - BOUND(i),
+            .kind = kind,
+            .descending = descending,
+        };
+    }
+    run_tasks(tasks, chunks, sort_task);
+
+    // There's a power of two amount of chunks, so they can always be merged in pairs
+    SortItem *from = items;
+    SortItem *to = tmp;
+    for (size_t width = 1; width < chunks; width *= 2) {
+        size_t pairs = 0;
+        for (size_t chunk = 0; chunk < chunks; chunk += 2 * width) {
+            size_t start = BOUND(chunk);
+            tasks[pairs++] = (struct sort_task) {
+                .items = from + start,
+                .tmp = to + start,
+                .length = BOUND(chunk + 2 * width) - start,
+                .left_length = BOUND(chunk + width) - start,
+                .kind = kind,
+                .descending = descending,
+            };
+        }
+        run_tasks(tasks, pairs, merge_task);
+
+        SortItem *swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from != items) {
+        memcpy(items, from, length * sizeof(*items));
+    }
+
+#undef BOUND
+    jrq_free(tasks);
+    jrq_free(tmp);
+}
+
+/// Sorts the elements of `list` by the element at the same index in `keys`, consumes `list` and
+/// borrows `keys`.
+static Json sort_list(Json list, Json keys, bool descending) {
+    size_t length = json_list_length(list);
+    assert(json_list_length(keys) == length);
+    if (length < 2) {
+        return list;
+    }
+
+    KeyKind kind;
+    switch (json_list_get_inner_type(keys)) {
+    case JSON_TYPE_NUMBER:
+        kind = KEYS_NUMBERS;
+        break;
+    case JSON_TYPE_STRING:
+        kind = KEYS_STRINGS;
+        break;
+    default:
+        kind = KEYS_ANY;
+        break;
+    }
+
+    JsonList *values = json_get_list(list);
+    JsonList *key_values = json_get_list(keys);
+    assert(length <= UINT32_MAX);
+    SortItem *items = jrq_malloc(length * sizeof(*items));
+    for (size_t i = 0; i < length; i++) {
+        items[i].index = i;
+        switch (kind) {
+        case KEYS_NUMBERS:
+            items[i].key.number = json_get_number(key_values->data[i]);
+            break;
+        case KEYS_STRINGS: {
+            String *string = json_get_string(key_values->data[i]);
+            items[i].key.string = string->data;
+            items[i].string_length = string->length;
+            break;
+        }
+        case KEYS_ANY:
+            items[i].key.json = &key_values->data[i];
+            break;
+        }
+    }
+
+    sort_parallel(items, length, kind, descending);
+
+    // If nothing else has the list the elements are put back into it in their new order, otherwise
+    // they go into a new list. Their references are taken in the order they're in, which is a lot
+    // kinder to the cache than doing it in the sorted order.
+    bool in_place = refcnt_get(list) == 1;
+    Json sorted = list;
+    Json *unsorted;
+    if (in_place) {
+        unsorted = jrq_malloc(length * sizeof(*unsorted));
+        memcpy(unsorted, values->data, length * sizeof(*unsorted));
+    } else {
+        unsorted = values->data;
+        for (size_t i = 0; i < length; i++) {
+            json_copy(unsorted[i]);
+        }
+        sorted = json_list_sized(length);
+        json_get_list(sorted)->length = length;
+        json_list_set_inner_type(sorted, json_list_get_inner_type(list));
+    }
+
+    Json *sorted_values = json_get_list(sorted)->data;
+    for (size_t i = 0; i < length; i++) {
+        sorted_values[i] = unsorted[items[i].index];
+    }
+
+    if (in_place) {
+        jrq_free(unsorted);
+    } else {
+        json_free(list);
+    }
+    jrq_free(items);
+    return sorted;
+}
+
+/// Sorts `list` by its elements with `json_compare`, keeping elements that are equal in the order
+/// they were in. Consumes `list`.
+Json json_list_sort(Json list, bool descending) {
+    return sort_list(list, list, descending);
+}
+
+/// Sorts `list` by `keys`, which has the key of each element at the same index, keeping elements
+/// with equal keys in the order they were in. Consumes both lists.
+///
+/// Every key is computed once up front instead of in every comparison, and if all of them are
+/// numbers or all of them are strings they are compared without looking at their types.
+Json json_list_sort_by(Json list, Json keys, bool descending) {
+    list = sort_list(list, keys, descending);
+    json_free(keys);
+    return list;
+}
@@ -0,0 +1,10 @@
+#ifndef _JSON_SORT_H
+#define _JSON_SORT_H
+
+#include "src/json.h"
+#include <stdbool.h>
+
+Json json_list_sort(Json list, bool descending);
+Json json_list_sort_by(Json list, Json keys, bool descending);
+
+#endif // _JSON_SORT_H
@@ -0,0 +1,93 @@
+#include "src/json_table.h"
+#include "src/alloc.h"
+#include "src/json.h"
+#include "src/vector.h"
+#include <assert.h>
+#include <stdlib.h>
+
+#define INITIAL_SLOTS 16
+
+static JsonTableEntry *find(JsonTable *t, uint64_t hash, Json key) {
+    if (t->slot_count == 0) {
+        return NULL;
+    }
+    size_t mask = t->slot_count - 1;
+    for (size_t i = hash & mask; t->slots[i] != 0; i = (i + 1) & mask) {
+        JsonTableEntry *entry = &t->entries.data[t->slots[i] - 1];
+        if (entry->hash == hash && json_equal(entry->key, key)) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static void insert_slot(JsonTable *t, uint64_t hash, uint32_t index) {
+    size_t mask = t->slot_count - 1;
+    size_t i = hash & mask;
+    while (t->slots[i] != 0) {
+        i = (i + 1) & mask;
+    }
+    t->slots[i] = index + 1;
+}
+
+static JsonTableEntry *lookup(JsonTable *t, Json key, uint64_t hash) {
+    JsonTableEntry *entry = find(t, hash, key);
+
+    // Numbers at the edge of a cell can equal numbers in the next one, see `json_hash`
+    uint64_t other;
+    if (entry == NULL && json_hash_other_cell(key, &other)) {
+        entry = find(t, other, key);
+    }
+    return entry;
+}
+
+/// Doubles the amount of slots, and puts every entry back in.
+static void grow(JsonTable *t) {
+    jrq_free(t->slots);
+    t->slot_count = t->slot_count == 0 ? INITIAL_SLOTS : t->slot_count * 2;
+    t->slots = jrq_calloc(t->slot_count, sizeof(*t->slots));
+    for (size_t i = 0; i < t->entries.length; i++) {
+        insert_slot(t, t->entries.data[i].hash, i);
+    }
+}
+
+/// The entry of `key`, or NULL if it isn't in the table.
+///
+/// Entries move when keys are added, so the entry is only valid until the next call to
+/// `json_table_entry`.
+JsonTableEntry *json_table_get(JsonTable *t, Json key) {
+    return lookup(t, key, json_hash(key));
+}
+
+/// The entry of `key`, which is added with a null value if it isn't in the table yet. Whether it
+/// was added is written to `added`.
+///
+/// Takes ownership of `key`, it's freed if the table already has it.
+JsonTableEntry *json_table_entry(JsonTable *t, Json key, bool *added) {
+    uint64_t hash = json_hash(key);
+    JsonTableEntry *entry = lookup(t, key, hash);
+    *added = entry == NULL;
+    if (entry != NULL) {
+        json_free(key);
+        return entry;
+    }
+
+    // Keep at most three quarters of the slots in use
+    if ((t->entries.length + 1) * 4 > t->slot_count * 3) {
+        grow(t);
+    }
+
+    vec_append(t->entries, (JsonTableEntry) {.hash = hash, .key = key, .value = json_null()});
+    insert_slot(t, hash, t->entries.length - 1);
+    return &t->entries.data[t->entries.length - 1];
+}
+
+void json_table_free(JsonTable *t) {
+    for (size_t i = 0; i < t->entries.length; i++) {
+        json_free(t->entries.data[i].key);
+        json_free(t->entries.data[i].value);
+    }
+    jrq_free(t->entries.data);
+    jrq_free(t->slots);
+    *t = (JsonTable) {0};
+}
@@ -0,0 +1,33 @@
+#ifndef _JSON_TABLE_H
+#define _JSON_TABLE_H
+
+#include "src/json.h"
+#include "src/vector.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    uint64_t hash;
+    Json key;
+    Json value;
+} JsonTableEntry;
+
+/// A hash table with json keys that are compared with `json_equal`, which keeps its entries in the
+/// order their keys were first added.
+///
+/// Start with a zeroed table, and free it with `json_table_free`.
+typedef struct {
+    /// The entries in the order they were added.
+    Vec(JsonTableEntry) entries;
+
+    /// Open addressing into `entries`, each slot is an index into `entries` plus one or 0 if it's
+    /// empty. There's a power of two amount of slots.
+    uint32_t *slots;
+    size_t slot_count;
+} JsonTable;
+
+JsonTableEntry *json_table_get(JsonTable *t, Json key);
+JsonTableEntry *json_table_entry(JsonTable *t, Json key, bool *added);
+void json_table_free(JsonTable *t);
+
+#endif // _JSON_TABLE_H
@@ -1,10 +1,15 @@
 #include "src/lexer.h"
 #include "src/alloc.h"
 #include "src/strings.h"
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/types.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #define min(a, b) ((a) < (b)) ? (a) : (b)
 #define max(a, b) ((a) > (b)) ? (a) : (b)
 
@@ -22,6 +27,222 @@ char *next_char(Lexer *l) {
     }
 }
 
+/// Moves the lexer forward to `to`, keeping track of the position like `next_char` would.
+void lex_advance_to(Lexer *l, char *to) {
+    for (char *c = l->str; c < to; c++) {
+        if (*c == '\n') {
+            l->position.line += 1;
+            l->position.col = 0;
+        }
+        l->position.col++;
+    }
+    l->str = to;
+}
+
+/// Finds the first `"`, `\` or NUL at or after `c`.
+///
+/// With SSE2, 16 characters are checked at once. Loads never cross into the next page, so reading
+/// past the end of the string can't fault, but it does look at bytes past the NUL, which is why
+/// this is hidden from the address sanitizer.
+__attribute__((no_sanitize_address)) static char *find_string_special(char *c) {
+#ifdef __SSE2__
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i zero = _mm_setzero_si128();
+
+    for (;;) {
+        if (((uintptr_t)c & 4095) > 4096 - 16) {
+            // Too close to the end of the page for a full load
+            if (*c == '"' || *c == '\\' || *c == '\0') {
+                return c;
+            }
+            c++;
+            continue;
+        }
+
+        __m128i chunk = _mm_loadu_si128((__m128i *)c);
+        __m128i hits = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+            _mm_cmpeq_epi8(chunk, zero)
+        );
+        int mask = _mm_movemask_epi8(hits);
+        if (mask != 0) {
+            return c + __builtin_ctz(mask);
+        }
+        c += 16;
+    }
+#else
+    while (*c != '"' && *c != '\\' && *c != '\0') {
+        c++;
+    }
+    return c;
+#endif
+}
+
+/// Finds the end of the string literal whose opening quote is at `start`.
+///
+/// If `escaped` isn't NULL, it's set to whether the string contains any escape sequences.
+///
+/// Returns a pointer to the closing quote, or to the terminating NUL if the string is unterminated.
+static char *string_end(char *start, bool *escaped) {
+    bool has_escapes = false;
+
+    char *c = start + 1;
+    for (;;) {
+        c = find_string_special(c);
+        if (*c != '\\') {
+            break;
+        }
+
+        has_escapes = true;
+        if (c[1] == '\0') {
+            c++;
+            break;
+        }
+        c += 2;
+    }
+
+    if (escaped != NULL) {
+        *escaped = has_escapes;
+    }
+    return c;
+}
+
+/// Finds the end of the string literal whose opening quote is at `start`, see `string_end`.
+char *lex_string_end(char *start) {
+    return string_end(start, NULL);
+}
+
+/// Writes `codepoint` to `out` as utf-8, returns the amount of bytes written.
+static int utf8_encode(uint codepoint, char *out) {
+    if (codepoint < 0x80) {
+        out[0] = (char)codepoint;
+        return 1;
+    }
+    if (codepoint < 0x800) {
+        out[0] = (char)(0xC0 | (codepoint >> 6));
+        out[1] = (char)(0x80 | (codepoint & 0x3F));
+        return 2;
+    }
+    if (codepoint < 0x10000) {
+        out[0] = (char)(0xE0 | (codepoint >> 12));
+        out[1] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (codepoint & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (codepoint >> 18));
+    out[1] = (char)(0x80 | ((codepoint >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (codepoint & 0x3F));
+    return 4;
+}
+
+/// Parses the 4 hex digits of a `\u` escape, returns -1 if they aren't valid.
+static int parse_hex4(char *c) {
+    int value = 0;
+    for (int i = 0; i < 4; i++) {
+        value <<= 4;
+        if ('0' <= c[i] && c[i] <= '9') {
+            value |= c[i] - '0';
+        } else if ('a' <= c[i] && c[i] <= 'f') {
+            value |= c[i] - 'a' + 10;
+        } else if ('A' <= c[i] && c[i] <= 'F') {
+            value |= c[i] - 'A' + 10;
+        } else {
+            return -1;
+        }
+    }
+    return value;
+}
+
+/// Decodes the escape sequences in the string literal `raw` into a newly allocated string.
+///
+/// The decoded string is never longer than `raw`, since every escape sequence is at least as long
+/// as what it decodes to.
+///
+/// Returns false if there was an invalid escape sequence.
+static bool decode_string(String raw, String *out) {
+    char *data = jrq_malloc(raw.length + 1);
+    char *o = data;
+
+    char *end = raw.data + raw.length;
+    for (char *c = raw.data; c < end;) {
+        char *backslash = memchr(c, '\\', end - c);
+        if (backslash == NULL) {
+            backslash = end;
+        }
+        memcpy(o, c, backslash - c);
+        o += backslash - c;
+        c = backslash;
+        if (c == end) {
+            break;
+        }
+
+        int codepoint;
+        switch (c[1]) {
+        case '"':
+        case '\\':
+        case '/':
+            *o++ = c[1];
+            c += 2;
+            continue;
+        case 'b':
+            *o++ = '\b';
+            c += 2;
+            continue;
+        case 'f':
+            *o++ = '\f';
+            c += 2;
+            continue;
+        case 'n':
+            *o++ = '\n';
+            c += 2;
+            continue;
+        case 'r':
+            *o++ = '\r';
+            c += 2;
+            continue;
+        case 't':
+            *o++ = '\t';
+            c += 2;
+            continue;
+        case 'u':
+            if (end - c < 6 || (codepoint = parse_hex4(c + 2)) < 0) {
+                jrq_free(data);
+                return false;
+            }
+            c += 6;
+
+            if (0xD800 <= codepoint && codepoint <= 0xDBFF) {
+                // A high surrogate has to be followed by a low surrogate to make a full codepoint
+                int low = (end - c >= 6 && c[0] == '\\' && c[1] == 'u') ? parse_hex4(c + 2) : -1;
+                if (0xDC00 <= low && low <= 0xDFFF) {
+                    codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                    c += 6;
+                } else {
+                    codepoint = 0xFFFD;
+                }
+            } else if (0xDC00 <= codepoint && codepoint <= 0xDFFF) {
+                codepoint = 0xFFFD;
+            }
+
+            o += utf8_encode(codepoint, o);
+            continue;
+        default:
+            jrq_free(data);
+            return false;
+        }
+    }
+
+    *o = '\0';
+    *out = (String) {
+        .data = data,
+        .length = (uint)(o - data),
+        .capacity = raw.length + 1,
+    };
+    return true;
+}
+
 #define peek_char(l) (l)->str[1]
 #define peek_char_n(l, n) (l)->str[n]
 #define char(l) *(l)->str
@@ -95,27 +316,22 @@ static LexResult parse_string(Lexer *l) {
     char *start = l->str;
     Position start_position = l->position;
 
-    bool backslashed = false;
-
-    for (;;) {
-        char c = *next_char(l);
-        if (c == '"' && !backslashed) {
-            break;
-        }
-        backslashed = false;
-        if (c == '\\') {
-            backslashed = true;
-        }
-        if (c == '\0') {
-            return (LexResult) {.error_message = "Unterminated string"};
-        }
+    bool escaped;
+    lex_advance_to(l, string_end(start, &escaped));
+    if (char(l) == '\0') {
+        return (LexResult) {.error_message = "Unterminated string"};
     }
 
     Position end_position = l->position;
 
     uint size = (uint)(l->str - start - 1);
 
+    // Strings without escapes point straight into the source, only strings with escapes are
+    // decoded into their own buffer.
     String string = string_from_str(start + 1, size);
+    if (escaped && !decode_string(string, &string)) {
+        return (LexResult) {.error_message = "Invalid escape sequence"};
+    }
 
     // Skip past the "
     next_char(l);
@@ -164,7 +380,7 @@ static LexResult parse_number(Lexer *l) {
 
     if (has_decimal) {
         double res = atof(number);
-        free(number);
+        jrq_free(number);
         return (LexResult) {
             .token = (Token) {
                 .type = TOKEN_NUMBER,
@@ -177,7 +393,7 @@ static LexResult parse_number(Lexer *l) {
         };
     } else {
         int res = atoi(number);
-        free(number);
+        jrq_free(number);
         return (LexResult) {
             .token = (Token) {
                 .type = TOKEN_NUMBER,
@@ -367,21 +583,18 @@ void parser_expect(Parser *p, TokenType expected, char *err) {
 }
 
 void tok_free(Token *tok) {
-    return;
-    // switch (tok->type) {
-    // case TOKEN_IDENT:
-    //     if (tok->inner.ident != NULL) {
-    //         free(tok->inner.ident);
-    //     }
-    //     break;
-    // case TOKEN_STRING:
-    //     if (tok->inner.string != NULL) {
-    //         free(tok->inner.string);
-    //     }
-    //     break;
-    // default:
-    //     break;
-    // }
+    // Only strings that had escape sequences own their data
+    if (tok->type == TOKEN_STRING && tok->inner.string.capacity != 0) {
+        jrq_free(tok->inner.string.data);
+        tok->inner.string.capacity = 0;
+    }
+}
+
+/// Takes the string out of a string token, so that freeing the token doesn't free the string.
+String tok_take_string(Token *tok) {
+    String s = tok->inner.string;
+    tok->inner.string.capacity = 0;
+    return s;
 }
 
 Token_norange tok_norange(Token t) {
@@ -107,8 +107,11 @@ void parser_expect(Parser *p, TokenType expected, char *err);
 
 Lexer lex_init(char *);
 LexResult lex_next_tok(Lexer *);
+void lex_advance_to(Lexer *, char *);
+char *lex_string_end(char *start);
 
 void tok_free(Token *tok);
+String tok_take_string(Token *tok);
 Token_norange tok_norange(Token t);
 
 Range range_combine(Range, Range);
@@ -4,6 +4,8 @@
 #include "src/json.h"
 #include "src/json_serde.h"
 #include "src/parser.h"
+#include "src/stats.h"
+#include <getopt.h>
 #include <memory.h>
 #include <stddef.h>
 #include <stdio.h>
@@ -11,69 +13,284 @@
 #include <string.h>
 #include <unistd.h>
 
-char *read_from_file(FILE *file) {
-    char *str = NULL;
-    size_t size = 0;
-    size_t bytes_read = getdelim(&str, &size, '\0', file);
+char *read_from_file(FILE *file, size_t *length) {
+    // Read with our own buffer instead of `getdelim`, so the input counts towards `--mem-limit`
+    size_t capacity = 64 * 1024;
+    size_t bytes_read = 0;
+    char *str = jrq_malloc(capacity);
+    size_t n;
+    while ((n = fread(str + bytes_read, 1, capacity - bytes_read - 1, file)) > 0) {
+        bytes_read += n;
+        if (capacity - bytes_read - 1 == 0) {
+            capacity *= 2;
+            str = jrq_realloc(str, capacity);
+        }
+    }
 
-    str = jrq_realloc(str, bytes_read + 1);
     str[bytes_read] = '\0';
+    *length = bytes_read;
     return str;
 }
 
+/// Parses an amount of bytes like `512`, `64k`, `100M` or `2G`, returns 0 if it isn't one.
+static size_t parse_size(const char *str) {
+    char *end;
+    unsigned long long size = strtoull(str, &end, 10);
+    if (end == str) {
+        return 0;
+    }
+    switch (*end) {
+    case 'k':
+    case 'K':
+        size <<= 10;
+        end++;
+        break;
+    case 'm':
+    case 'M':
+        size <<= 20;
+        end++;
+        break;
+    case 'g':
+    case 'G':
+        size <<= 30;
+        end++;
+        break;
+    }
+    return *end == '\0' ? size : 0;
+}
+
+static void memory_limit_exceeded(size_t size) {
+    fprintf(
+        stderr,
+        "Error: allocating %zu bytes would go over the memory limit of %zu bytes\n",
+        size,
+        jrq_mem_limit
+    );
+    exit(1);
+}
+
+static const struct option OPTIONS[] = {
+    {"ascii", no_argument, NULL, 'a'},
+    {"compact", no_argument, NULL, 'c'},
+    {"mem-limit", required_argument, NULL, 'm'},
+    {"ndjson", no_argument, NULL, 'n'},
+    {"profile", no_argument, NULL, 'p'},
+    {"raw", no_argument, NULL, 'r'},
+    {"stats", no_argument, NULL, 's'},
+    {0},
+};
+
+typedef struct {
+    JsonSerializeFlags flags;
+    size_t written;
+} Output;
+
+/// Writes every element of a streamed result on its own line.
+static void output_line(Json json, void *data) {
+    Output *output = data;
+    output->written += json_serialize_to(stdout, &json, output->flags) + 1;
+    json_free(json);
+    putchar('\n');
+}
+
+/// Writes the statistics to stderr, if they were asked for.
+static void report_stats(Stats *stats) {
+    if (stats == NULL) {
+        return;
+    }
+    char *report = stats_format(stats);
+    fprintf(stderr, "%s\n", report);
+    jrq_free(report);
+}
+
 int main(int argc, char **argv) {
-    char *str = read_from_file(stdin);
+    JsonSerializeFlags flags = JSON_FLAG_TAB | JSON_FLAG_SPACES;
+    bool profiling = false;
+    Stats stats = {0};
+    Stats *s = NULL;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "acm:nprs", OPTIONS, NULL)) != -1) {
+        switch (opt) {
+        case 'a':
+            flags |= JSON_FLAG_ASCII;
+            break;
+        case 'c':
+            flags &= ~(JSON_FLAG_TAB | JSON_FLAG_SPACES);
+            break;
+        case 'm':
+            jrq_mem_limit = parse_size(optarg);
+            if (jrq_mem_limit == 0) {
+                fprintf(stderr, "Invalid memory limit '%s'\n", optarg);
+                exit(2);
+            }
+            break;
+        case 'n':
+            flags &= ~(JSON_FLAG_TAB | JSON_FLAG_SPACES);
+            flags |= JSON_FLAG_NDJSON;
+            break;
+        case 'p':
+            profiling = true;
+            break;
+        case 'r':
+            flags |= JSON_FLAG_RAW;
+            break;
+        case 's':
+            s = &stats;
+            json_count_created = true;
+            break;
+        default:
+            fprintf(
+                stderr,
+                "Usage: %s [--ascii] [--compact] [--mem-limit=SIZE] [--ndjson] [--profile] [--raw] "
+                "[--stats] [query]\n",
+                argv[0]
+            );
+            exit(2);
+        }
+    }
+    char *code = optind < argc ? argv[optind] : NULL;
+
+    // The limit can only be checked when it's known how much memory is in use, and the peak is
+    // worth reporting in the statistics. Counting is shared between threads, so nothing is counted
+    // unless it's reported.
+    const JrqAllocator *allocator = &JRQ_ALLOCATOR_LIBC;
+    if (jrq_mem_limit != 0 || s != NULL) {
+        allocator = &JRQ_ALLOCATOR_PEAK;
+    } else if (profiling) {
+        allocator = &JRQ_ALLOCATOR_COUNTING;
+    }
+    char *allocator_name = getenv("JRQ_ALLOCATOR");
+    if (jrq_mem_limit == 0 && allocator_name != NULL) {
+        allocator = jrq_allocator_from_name(allocator_name);
+        if (allocator == NULL) {
+            fprintf(stderr, "Unknown allocator '%s'\n", allocator_name);
+            exit(2);
+        }
+    }
+    jrq_set_allocator(allocator);
+    if (jrq_mem_limit != 0) {
+        jrq_out_of_memory = memory_limit_exceeded;
+    }
+
+    if (isatty(STDOUT_FILENO)) {
+        flags |= JSON_FLAG_COLORS;
+    }
+
+    stats_begin(s, PHASE_READ);
+    char *str = read_from_file(stdin, &stats.bytes_read);
+    stats_end(s);
+
+    // The query is parsed first so that we know what parts of the input it needs. Errors in the
+    // input are still reported before errors in the query.
+    ParseResult parse_res = {0};
+    Projection *projection = NULL;
+    if (code != NULL) {
+        stats_begin(s, PHASE_PARSE);
+        parse_res = ast_parse(code);
+        if (parse_res.type == RES_OK) {
+            projection = eval_projection(parse_res.node);
+        }
+        stats_end(s);
+    }
+
+    stats_begin(s, PHASE_DESERIALIZE);
+    DeserializeResult res;
+    if (projection == NULL) {
+        res = json_deserialize_parallel(str, 0);
+    } else if (projection->whole) {
+        // Most of the input may still be unused, so only parse what's looked at.
+        res = json_deserialize_lazy(str);
+    } else {
+        res = json_deserialize_projected(str, projection);
+    }
+    projection_free(projection);
+    stats_end(s);
 
-    DeserializeResult res = json_deserialize(str);
     if (res.type == RES_ERR) {
         char *err_string = jrq_error_format(res.err, str);
         printf("%s\n", err_string);
-        free(err_string);
+        jrq_free(err_string);
+        report_stats(s);
 
-        free(str);
+        if (parse_res.type == RES_OK) {
+            ast_free(parse_res.node);
+        } else {
+            jrq_free(parse_res.err.err);
+        }
+        jrq_free(str);
         exit(1);
     }
 
     Json result = res.result;
 
-    if (argc > 1) {
-        char *code = argv[1];
-        ParseResult parse_res = ast_parse(code);
+    if (code != NULL) {
         if (parse_res.type == RES_ERR) {
             char *err_string = jrq_error_format(parse_res.err, code);
             printf("%s\n", err_string);
             json_free(result);
-            free(str);
-            free(err_string);
+            jrq_free(str);
+            jrq_free(err_string);
+            report_stats(s);
             exit(1);
         }
 
         ASTNode *ast = parse_res.node;
 
-        EvalResult eval_res = eval(ast, result);
+        Profile *profile = profiling ? profile_new(ast) : NULL;
+
+        // Results of iterators are written out as they're produced when each one is on its own
+        // line, so then the time spent writing them out is part of the time spent evaluating.
+        Output output = {.flags = flags & ~JSON_FLAG_NDJSON};
+        stats_begin(s, PHASE_EVAL);
+        EvalResult eval_res = eval_stream(
+            ast,
+            result,
+            (flags & JSON_FLAG_NDJSON) ? output_line : NULL,
+            &output,
+            profile
+        );
         json_free(result);
+        stats_end(s);
+        stats.bytes_written += output.written;
+
+        if (profile != NULL) {
+            char *report = profile_format(profile, code);
+            fprintf(stderr, "%s", report);
+            jrq_free(report);
+            profile_free(profile);
+        }
 
         if (eval_res.type == RES_ERR) {
             char *err_string = jrq_error_format(eval_res.err, code);
             printf("%s\n", err_string);
-            free(str);
-            free(err_string);
+            jrq_free(str);
+            jrq_free(err_string);
+            report_stats(s);
             exit(1);
         }
 
+        if (eval_res.streamed) {
+            jrq_free(str);
+            report_stats(s);
+            return 0;
+        }
+
         // Change result to be the result of the evaluation.
         result = eval_res.json;
     }
 
-    JsonSerializeFlags flags = JSON_FLAG_TAB | JSON_FLAG_SPACES;
-    if (isatty(STDOUT_FILENO)) {
-        flags = JSON_FLAG_TAB | JSON_FLAG_SPACES | JSON_FLAG_COLORS;
-    }
-    char *out = json_serialize(&result, flags);
+    stats_begin(s, PHASE_SERIALIZE);
+    stats.bytes_written += json_serialize_to(stdout, &result, flags);
     json_free(result);
-    printf("%s\n", out);
+    if (!(flags & JSON_FLAG_NDJSON)) {
+        putchar('\n');
+        stats.bytes_written++;
+    }
+    fflush(stdout);
+    stats_end(s);
 
-    free(str);
-    free(out);
+    jrq_free(str);
+    report_stats(s);
     return 0;
 }
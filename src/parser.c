@@ -174,7 +174,7 @@ static ASTNode *function_call(Parser *p, ASTNode *callee, Token function_name) {
     function->inner.function.args = args;
     function->inner.function.callee = callee;
     function->inner.function.function_name = tok_norange(function_name);
-    // Don't update the function's range here, the range for a function is handled in `access`
+    // Don't update the function's range here, the range for a function is handled by the caller
     return function;
 }
 
@@ -266,11 +266,21 @@ static ASTNode *primary(Parser *p) {
     // clang-format on
 
     if (parser_matches(p, LIST((TokenType[]) {TOKEN_STRING, TOKEN_NUMBER, TOKEN_IDENT}))) {
+        Token token = p->prev;
+
+        // An identifier followed by a ( is a free function, like `range(10)`
+        if (token.type == TOKEN_IDENT && parser_matches(p, LIST((TokenType[]) {TOKEN_LPAREN}))) {
+            ASTNode *function = function_call(p, NULL, token);
+            function->inner.function.is_free = true;
+            function->range = range_combine(token.range, p->prev.range);
+            return function;
+        }
+
         ASTNode *new_expr = jrq_calloc(sizeof(ASTNode), 1);
 
         new_expr->type = AST_TYPE_PRIMARY;
-        new_expr->inner.primary = tok_norange(p->prev);
-        new_expr->range = p->prev.range;
+        new_expr->inner.primary = tok_norange(token);
+        new_expr->range = token.range;
         return new_expr;
     }
 
@@ -411,7 +421,7 @@ static void ast_vec_free(Vec_ASTNode vec) {
         ast_free(vec.data[i]);
     }
 
-    free((ASTNode *)vec.data);
+    jrq_free((ASTNode *)vec.data);
 }
 
 void ast_free(ASTNode *n) {
@@ -464,5 +474,5 @@ void ast_free(ASTNode *n) {
         break;
     }
 
-    free(n);
+    jrq_free(n);
 }
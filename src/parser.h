@@ -69,10 +69,17 @@ typedef struct ASTNode {
 
         /// Function call:
         /// <expr: callee> "." <ident: function_name> "(" <(expr ",")*: args> ")"
+        ///
+        /// Can also be written without a callee as a free function, like `range(10)`
+        /// <ident: function_name> "(" <(expr ",")*: args> ")"
+        ///
+        /// A free function has a NULL callee, but so does `.map()`, so `is_free` is what tells the
+        /// two apart.
         struct {
             struct ASTNode *callee;
             Token_norange function_name;
             Vec_ASTNode args;
+            bool is_free;
         } function;
 
         /// Closure body:
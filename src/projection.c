@@ -0,0 +1,66 @@
+#include "src/projection.h"
+#include "src/alloc.h"
+#include "src/strings.h"
+#include "src/vector.h"
+#include <stdlib.h>
+
+Projection *projection_new(void) {
+    return jrq_calloc(sizeof(Projection), 1);
+}
+
+/// Find the projection of the field `key`, or NULL if the field isn't part of `p`.
+Projection *projection_find_field(Projection *p, String key) {
+    for (size_t i = 0; i < p->fields.length; i++) {
+        if (string_equal(p->fields.data[i].key, key)) {
+            return p->fields.data[i].projection;
+        }
+    }
+    return NULL;
+}
+
+/// Get the projection of the field `key`, adding the field to `p` if it isn't part of it yet.
+///
+/// `key` is not copied, so it must outlive `p`.
+Projection *projection_field(Projection *p, String key) {
+    Projection *field = projection_find_field(p, key);
+    if (field == NULL) {
+        field = projection_new();
+        vec_append(p->fields, (ProjectionField) {.key = key, .projection = field});
+    }
+    return field;
+}
+
+/// Get the projection of the elements of `p`, creating it if no elements were read yet.
+Projection *projection_elements(Projection *p) {
+    if (p->elements == NULL) {
+        p->elements = projection_new();
+    }
+    return p->elements;
+}
+
+/// Add everything that is needed by `src` to `dst`.
+void projection_merge(Projection *dst, Projection *src) {
+    dst->whole |= src->whole;
+
+    for (size_t i = 0; i < src->fields.length; i++) {
+        ProjectionField field = src->fields.data[i];
+        projection_merge(projection_field(dst, field.key), field.projection);
+    }
+
+    if (src->elements != NULL) {
+        projection_merge(projection_elements(dst), src->elements);
+    }
+}
+
+void projection_free(Projection *p) {
+    if (p == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < p->fields.length; i++) {
+        projection_free(p->fields.data[i].projection);
+    }
+    jrq_free(p->fields.data);
+    projection_free(p->elements);
+    jrq_free(p);
+}
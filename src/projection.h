@@ -0,0 +1,42 @@
+#ifndef _PROJECTION_H
+#define _PROJECTION_H
+
+#include "src/strings.h"
+#include "src/vector.h"
+#include <stdbool.h>
+
+typedef struct Projection Projection;
+
+typedef struct {
+    String key;
+    Projection *projection;
+} ProjectionField;
+
+typedef Vec(ProjectionField) ProjectionFields;
+
+/// The parts of a json value that a query can read.
+///
+/// For example, `.items.map(|v| v.price)` only needs the `price` field of every element of the
+/// `items` field of the input, so its projection looks like `{items: {elements: {price: whole}}}`.
+///
+/// Anything that is not part of the projection never needs to be parsed.
+struct Projection {
+    /// The value is used as a whole (it's output, compared, iterated over as an object, ...), so
+    /// everything inside of it is needed.
+    bool whole;
+
+    /// Fields of an object that are read, and what is needed of each of them.
+    ProjectionFields fields;
+
+    /// What is needed of every element of a list, or NULL if no element is ever read.
+    Projection *elements;
+};
+
+Projection *projection_new(void);
+Projection *projection_field(Projection *p, String key);
+Projection *projection_find_field(Projection *p, String key);
+Projection *projection_elements(Projection *p);
+void projection_merge(Projection *dst, Projection *src);
+void projection_free(Projection *p);
+
+#endif // _PROJECTION_H
@@ -0,0 +1,105 @@
+#include "src/stats.h"
+#include "src/alloc.h"
+#include "src/json.h"
+#include "src/strings.h"
+#include <sys/resource.h>
+#include <time.h>
+
+static const char *PHASE_NAMES[PHASE_COUNT] = {
+    [PHASE_READ] = "read",
+    [PHASE_PARSE] = "parse",
+    [PHASE_DESERIALIZE] = "deserialize",
+    [PHASE_EVAL] = "eval",
+    [PHASE_SERIALIZE] = "serialize",
+};
+
+static uint64_t clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+/// Start timing `phase`. Nothing is recorded if `stats` is NULL.
+void stats_begin(Stats *stats, Phase phase) {
+    if (stats == NULL) {
+        return;
+    }
+    stats->phase = phase;
+    stats->wall_start = clock_ns(CLOCK_MONOTONIC);
+    // Includes the time of every thread, parsing can be done in parallel
+    stats->cpu_start = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+/// Stop timing the phase that was begun last.
+void stats_end(Stats *stats) {
+    if (stats == NULL) {
+        return;
+    }
+    stats->wall_ns[stats->phase] += clock_ns(CLOCK_MONOTONIC) - stats->wall_start;
+    stats->cpu_ns[stats->phase] += clock_ns(CLOCK_PROCESS_CPUTIME_ID) - stats->cpu_start;
+}
+
+/// Formats `stats` as a single line of json, along with what has been allocated so far.
+///
+/// The json is written by hand instead of through `json_serialize`, that would allocate and it
+/// writes numbers with `%g`, which rounds big counts.
+char *stats_format(Stats *stats) {
+    String out = string_from_chars_alloc("{\"phases\": {");
+
+    uint64_t wall_total = 0;
+    uint64_t cpu_total = 0;
+    for (Phase phase = 0; phase < PHASE_COUNT; phase++) {
+        string_printf(
+            &out,
+            "%s\"%s\": {\"wall_ms\": %.3f, \"cpu_ms\": %.3f}",
+            phase == 0 ? "" : ", ",
+            PHASE_NAMES[phase],
+            (double)stats->wall_ns[phase] / 1e6,
+            (double)stats->cpu_ns[phase] / 1e6
+        );
+        wall_total += stats->wall_ns[phase];
+        cpu_total += stats->cpu_ns[phase];
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    string_printf(
+        &out,
+        "}, \"wall_ms\": %.3f, \"cpu_ms\": %.3f, \"bytes_read\": %zu, \"bytes_written\": %zu, "
+        "\"json_created\": {\"list\": %zu, \"object\": %zu, \"string\": %zu}, "
+        "\"allocations\": %zu, \"allocated_bytes\": %zu, \"peak_rss_kb\": %ld",
+        (double)wall_total / 1e6,
+        (double)cpu_total / 1e6,
+        stats->bytes_read,
+        stats->bytes_written,
+        json_created[JSON_TYPE_LIST],
+        json_created[JSON_TYPE_OBJECT],
+        json_created[JSON_TYPE_STRING],
+        jrq_allocations,
+        jrq_allocated_bytes,
+        usage.ru_maxrss
+    );
+
+    // These are only known with the allocators that keep track of them
+    if (jrq_peak_bytes != 0) {
+        string_printf(&out, ", \"peak_heap_bytes\": %zu", jrq_peak_bytes);
+    }
+    size_t last_class = JRQ_SIZE_CLASSES;
+    while (last_class > 0 && jrq_size_classes[last_class - 1] == 0) {
+        last_class--;
+    }
+    if (last_class > 0) {
+        // Keyed by the most bytes allocations of each class can be
+        string_printf(&out, ", \"size_classes\": {");
+        for (size_t i = 0; i < last_class; i++) {
+            string_printf(
+                &out, "%s\"%zu\": %zu", i == 0 ? "" : ", ", (1ul << i) - 1, jrq_size_classes[i]
+            );
+        }
+        string_printf(&out, "}");
+    }
+
+    string_printf(&out, "}");
+    return out.data;
+}
@@ -0,0 +1,35 @@
+#ifndef _STATS_H
+#define _STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// The parts that running jrq is made out of, in the order they happen.
+typedef enum {
+    PHASE_READ,
+    PHASE_PARSE,
+    PHASE_DESERIALIZE,
+    PHASE_EVAL,
+    PHASE_SERIALIZE,
+
+    PHASE_COUNT,
+} Phase;
+
+typedef struct {
+    uint64_t wall_ns[PHASE_COUNT];
+    uint64_t cpu_ns[PHASE_COUNT];
+
+    /// When the phase that is running right now started
+    Phase phase;
+    uint64_t wall_start;
+    uint64_t cpu_start;
+
+    size_t bytes_read;
+    size_t bytes_written;
+} Stats;
+
+void stats_begin(Stats *stats, Phase phase);
+void stats_end(Stats *stats);
+char *stats_format(Stats *stats);
+
+#endif // _STATS_H
@@ -5,28 +5,100 @@
 #include <stdio.h>
 #include <string.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 void string_grow(String *str, uint amt) {
     vec_grow(*str, amt);
 }
 
-bool string_equal(String a, String b) {
-    if (a.length != b.length) {
-        return false;
-    }
-    return strncmp(string_get(&a), string_get(&b), a.length) == 0;
-}
-
 char *string_get(String *str) {
     return str->data;
 }
 
 void string_append(String *a, String b) {
     string_grow(a, b.length + 1);
-    strncpy((a->data + a->length), string_get(&b), b.length);
+    memcpy((a->data + a->length), string_get(&b), b.length);
     a->length += b.length;
     string_get(a)[a->length] = '\0';
 }
 
+/// A 64 bit hash of the bytes of `s`, which reads 8 bytes at a time.
+uint64_t string_hash(String s) {
+    const uint64_t K = 0x9e3779b97f4a7c15ull;
+    uint64_t h = s.length * K;
+
+    uint i = 0;
+    for (; i + 8 <= s.length; i += 8) {
+        uint64_t word;
+        memcpy(&word, s.data + i, sizeof(word));
+        h = (h ^ word) * K;
+        h ^= h >> 29;
+    }
+    if (i < s.length) {
+        uint64_t word = 0;
+        memcpy(&word, s.data + i, s.length - i);
+        h = (h ^ word) * K;
+        h ^= h >> 29;
+    }
+
+    h ^= h >> 32;
+    h *= K;
+    return h ^ (h >> 29);
+}
+
+/// Whether `byte` continues a utf-8 character instead of starting one.
+static inline bool is_continuation(char byte) {
+    return ((unsigned char)byte & 0xc0) == 0x80;
+}
+
+/// The amount of utf-8 codepoints in `s`, which is the amount of bytes that don't continue a
+/// character. The bytes aren't checked to be valid utf-8.
+size_t string_codepoints(String s) {
+    size_t continuations = 0;
+    uint i = 0;
+#ifdef __SSE2__
+    // Continuation bytes are 0x80 to 0xbf, which are the only bytes below 0xc0 when signed
+    const __m128i limit = _mm_set1_epi8((char)0xc0);
+    for (; i + 16 <= s.length; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(s.data + i));
+        continuations += __builtin_popcount(_mm_movemask_epi8(_mm_cmplt_epi8(chunk, limit)));
+    }
+#endif
+    for (; i < s.length; i++) {
+        continuations += is_continuation(s.data[i]);
+    }
+    return s.length - continuations;
+}
+
+/// The offset of the byte that codepoint `index` of `s` starts at, or the length of `s` if it has
+/// fewer codepoints than that.
+size_t string_codepoint_offset(String s, size_t index) {
+    uint i = 0;
+#ifdef __SSE2__
+    // Chunks that the codepoint doesn't start in are skipped over by counting what starts in them
+    const __m128i limit = _mm_set1_epi8((char)0xc0);
+    for (; i + 16 <= s.length; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(s.data + i));
+        size_t starts = 16 - __builtin_popcount(_mm_movemask_epi8(_mm_cmplt_epi8(chunk, limit)));
+        if (starts > index) {
+            break;
+        }
+        index -= starts;
+    }
+#endif
+    for (; i < s.length; i++) {
+        if (!is_continuation(s.data[i])) {
+            if (index == 0) {
+                return i;
+            }
+            index--;
+        }
+    }
+    return s.length;
+}
+
 void string_printf(String *s, const char *fmt, ...) {
     va_list args1, args2;
     va_start(args1, fmt);
@@ -43,18 +115,6 @@ void string_printf(String *s, const char *fmt, ...) {
     va_end(args2);
 }
 
-String string_from_str(char *str, uint len) {
-    return (String) {
-        .data = str,
-        .length = len,
-        .capacity = 0,
-    };
-}
-
-String string_from_chars(char *str) {
-    return string_from_str(str, strlen(str));
-}
-
 String string_from_str_alloc(char *str, uint len) {
     uint capacity;
     char *data;
@@ -63,8 +123,11 @@ String string_from_str_alloc(char *str, uint len) {
         capacity = 32;
         data = jrq_malloc(capacity);
     } else {
-        capacity = len;
-        data = jrq_strndup(str, len);
+        // Copy with memcpy, the string could contain NULs
+        capacity = len + 1;
+        data = jrq_malloc(capacity);
+        memcpy(data, str, len);
+        data[len] = '\0';
     }
 
     return (String) {
@@ -2,6 +2,8 @@
 #define _STRINGS_H
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
 #include <sys/types.h>
 
 typedef struct {
@@ -11,13 +13,44 @@ typedef struct {
 } String;
 
 void string_grow(String *, uint);
-bool string_equal(String, String);
 char *string_get(String *);
 void string_append(String *, String);
 void string_printf(String *, const char *, ...);
-String string_from_str(char *, uint);
-String string_from_chars(char *);
+uint64_t string_hash(String);
+size_t string_codepoints(String);
+size_t string_codepoint_offset(String, size_t);
 String string_from_str_alloc(char *, uint);
 String string_from_chars_alloc(char *);
 
+/// Whether `a` and `b` have the same bytes, either can contain NULs.
+///
+/// This is inline so that comparing against a literal, like the names of functions, is only a
+/// length check for most strings.
+static inline bool string_equal(String a, String b) {
+    return a.length == b.length && (a.length == 0 || memcmp(a.data, b.data, a.length) == 0);
+}
+
+/// Orders `a` and `b` by their bytes, a string comes before the strings it's a prefix of. For utf-8
+/// this is the same as ordering by codepoints.
+static inline int string_compare(String a, String b) {
+    uint length = a.length < b.length ? a.length : b.length;
+    int cmp = length == 0 ? 0 : memcmp(a.data, b.data, length);
+    if (cmp != 0) {
+        return cmp;
+    }
+    return (a.length > b.length) - (a.length < b.length);
+}
+
+static inline String string_from_str(char *str, uint len) {
+    return (String) {
+        .data = str,
+        .length = len,
+        .capacity = 0,
+    };
+}
+
+static inline String string_from_chars(char *str) {
+    return string_from_str(str, strlen(str));
+}
+
 #endif // _STRINGS_H
@@ -1,9 +1,112 @@
 #include "../src/json.h"
+#include "src/errors.h"
+#include "src/json_serde.h"
+#include "src/strings.h"
 #include "src/utils.h"
 #include "src/vector.h"
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+// Builds a top level list big enough for `json_deserialize_parallel` to actually use threads.
+//
+// `middle` is inserted as an element halfway through the list.
+static char *big_list(char *middle) {
+    String s = string_from_chars_alloc("[");
+    for (int i = 0; i < 40000; i++) {
+        if (i == 20000) {
+            string_printf(&s, "%s, ", middle);
+        }
+        string_printf(
+            &s,
+            "{\"id\": %d, \"name\": \"user, [%d]\", \"tags\": [\"a\", \"b\\\"\"], "
+            "\"nested\": {\"x\": [1, -2.5, {\"y\": null}]}}%s\n",
+            i,
+            i,
+            i + 1 == 40000 ? "" : ","
+        );
+    }
+    string_append(&s, string_from_chars("]  "));
+    return s.data;
+}
+
+// The type of the elements of `j` if it's a list.
+static JsonType inner_type(Json j) {
+    return json_get_type(j) == JSON_TYPE_LIST ? json_list_get_inner_type(j) : JSON_TYPE_INVALID;
+}
+
+static void test_parallel(char *input) {
+    DeserializeResult seq = json_deserialize(input);
+    for (uint threads = 1; threads <= 8; threads *= 2) {
+        printf("Testing parallel deserialize with %d threads\n", threads);
+        DeserializeResult par = json_deserialize_parallel(input, threads);
+
+        assert(seq.type == par.type);
+        if (seq.type == RES_ERR) {
+            assert(strcmp(seq.err.err, par.err.err) == 0);
+            assert(memcmp(&seq.err.range, &par.err.range, sizeof(Range)) == 0);
+            jrq_free(par.err.err);
+        } else {
+            assert(json_equal(seq.result, par.result));
+            assert(inner_type(seq.result) == inner_type(par.result));
+            json_free(par.result);
+        }
+    }
+
+    if (seq.type == RES_ERR) {
+        jrq_free(seq.err.err);
+    } else {
+        json_free(seq.result);
+    }
+    jrq_free(input);
+}
+
+static void test_lazy(char *input) {
+    printf("Testing lazy deserialize of %s\n", input);
+    DeserializeResult eager = json_deserialize(input);
+    DeserializeResult lazy = json_deserialize_lazy(input);
+
+    assert(eager.type == lazy.type);
+    if (eager.type == RES_ERR) {
+        assert(strcmp(eager.err.err, lazy.err.err) == 0);
+        assert(memcmp(&eager.err.range, &lazy.err.range, sizeof(Range)) == 0);
+        jrq_free(eager.err.err);
+        jrq_free(lazy.err.err);
+        return;
+    }
+
+    assert(inner_type(eager.result) == inner_type(lazy.result));
+    if (json_get_type(eager.result) == JSON_TYPE_OBJECT) {
+        // Looking up single fields should only parse those fields
+        Json key = json_string("b");
+        assert(json_equal(json_object_get(eager.result, key), json_object_get(lazy.result, key)));
+        json_free(key);
+    }
+    assert(json_equal(eager.result, lazy.result));
+
+    json_free(eager.result);
+    json_free(lazy.result);
+}
 
 int main() {
+    test_lazy("10");
+    test_lazy("[]");
+    test_lazy("[1, \"a\", [2, 3], {\"x\": [[]]}]");
+    test_lazy("[[1, 2], [\"a\"], []]");
+    test_lazy("{\"a\": {\"c\": \"}]\\\"\"}, \"b\": [1, {\"d\": 2}], \"b\": [false]}");
+    test_lazy("{\"a\": [1, 2}");
+    test_lazy("[1, {\"a\": -}]");
+    test_lazy("{\"a\": [1]} 1");
+
+
+    test_parallel(big_list("10"));
+    test_parallel(big_list("\"mixed\""));
+    test_parallel(big_list("[[], {}]"));
+
+    test_parallel(big_list("10 11"));
+    test_parallel(big_list("{\"foo\" 10}"));
+    test_parallel(big_list("[1}"));
+    test_parallel(big_list("}"));
+    test_parallel(big_list(""));
 }
@@ -1,9 +1,12 @@
 #include "src/json.h"
 #include "src/json_iter.h"
+#include "src/json_sort.h"
 #include <assert.h>
 #include <stdio.h>
 
 Json mapper(Json, void *);
+Json first(Json, void *);
+bool below_three(Json, void *);
 
 #define LIST(s...) s, (sizeof(s) / sizeof(*(s)))
 
@@ -67,6 +70,130 @@ void split_iter() {
             json_string("cry")
         )
     );
+
+    // Separators that start with a part of themselves, and that only partly match at the end
+    test_iter(
+        iter_split(json_string("aaab,aab"), json_string("aab")),
+        JSON_LIST(json_string("a"), json_string(","))
+    );
+    test_iter(
+        iter_split(json_string("a, b,, c,"), json_string(", ")),
+        JSON_LIST(json_string("a"), json_string("b,"), json_string("c,"))
+    );
+    test_iter(
+        iter_split(json_string("a long line\n\nanother long line\n"), json_string("\n")),
+        JSON_LIST(json_string("a long line"), json_string(""), json_string("another long line"))
+    );
+    test_iter(
+        iter_split(json_string("abc"), json_string("")),
+        JSON_LIST(json_string("a"), json_string("b"), json_string("c"))
+    );
+
+    Json pieces = iter_collect(iter_split(
+        json_string("one, two, three, four, five, six, seven, eight, nine"), json_string(", ")
+    ));
+    assert(json_list_length(pieces) == 9);
+    Json last = json_string("nine");
+    assert(json_equal(json_list_get(pieces, 8), last));
+    json_free(last);
+    json_free(pieces);
+}
+
+void unique_iter() {
+    test_iter(
+        iter_unique(
+            iter_list(JSON_LIST(
+                json_string("a"),
+                json_number(1),
+                json_string("a"),
+                JSON_LIST(json_number(1), json_string("b")),
+                json_number(1),
+                JSON_LIST(json_number(1), json_string("b")),
+                json_null(),
+                json_null()
+            )),
+            NULL,
+            NULL,
+            false
+        ),
+        JSON_LIST(
+            json_string("a"),
+            json_number(1),
+            JSON_LIST(json_number(1), json_string("b")),
+            json_null()
+        )
+    );
+
+    // Numbers within EPSILON are equal, even right at the edge of what they're hashed by
+    test_iter(
+        iter_unique(
+            iter_list(JSON_LIST(
+                json_number(0.1 + 0.2),
+                json_number(0.3),
+                json_number(0.0000005),
+                json_number(0.0000005 - 0.000000005),
+                json_number(0.0000005 + 0.000000005)
+            )),
+            NULL,
+            NULL,
+            false
+        ),
+        JSON_LIST(json_number(0.3), json_number(0.0000005))
+    );
+}
+
+void top_k_iter() {
+    // Elements are `[key, position]` with plenty of equal keys, which have to stay in order
+    Json elements = json_list();
+    Json keys = json_list();
+    for (int i = 0; i < 200; i++) {
+        int key = (i * 37) % 23;
+        elements = json_list_append(elements, JSON_LIST(json_number(key), json_number(i)));
+        keys = json_list_append(keys, json_number(key));
+    }
+
+    for (int largest = 0; largest <= 1; largest++) {
+        Json sorted = json_list_sort_by(json_copy(elements), json_copy(keys), largest);
+        for (int k = 0; k <= 210; k += 15) {
+            Json top = iter_top_k(iter_list(json_copy(elements)), k, &first, NULL, largest);
+            assert(json_list_length(top) == (k < 200 ? k : 200));
+            for (int i = 0; i < json_list_length(top); i++) {
+                assert(json_equal(json_list_get(top, i), json_list_get(sorted, i)));
+            }
+            json_free(top);
+        }
+        json_free(sorted);
+    }
+
+    json_free(elements);
+    json_free(keys);
+}
+
+void range_iter() {
+    test_iter(iter_range(0, 3, 1), JSON_LIST(json_number(0), json_number(1), json_number(2)));
+    test_iter(iter_range(10, 0, -4), JSON_LIST(json_number(10), json_number(6), json_number(2)));
+    test_iter(
+        iter_range(0, 1, 0.25),
+        JSON_LIST(json_number(0), json_number(0.25), json_number(0.5), json_number(0.75))
+    );
+    test_iter(iter_range(3, 0, 1), json_list());
+
+    // Only the numbers that are taken are ever made
+    test_iter(
+        iter_take(iter_range(0, 1e18, 7), 3),
+        JSON_LIST(json_number(0), json_number(7), json_number(14))
+    );
+
+    // Iterators that drop elements don't know how many are left, collecting them mustn't reserve
+    // room for the whole range
+    Json expected = JSON_LIST(json_number(0), json_number(1), json_number(2));
+    Json kept = iter_collect(iter_filter(iter_range(0, 1e7, 1), &below_three, NULL, false));
+    assert(json_equal(kept, expected));
+    json_free(kept);
+    kept = iter_collect(iter_take_while(iter_range(0, 1e18, 1), &below_three, NULL, false));
+    assert(json_equal(kept, expected));
+    json_free(kept);
+    json_free(expected);
 }
 
 int main() {
@@ -74,8 +201,21 @@ int main() {
     map_iter();
     enumerate_iter();
     split_iter();
+    unique_iter();
+    top_k_iter();
+    range_iter();
 }
 
 Json mapper(Json j, void *_) {
     return json_number(json_get_number(j) * 2);
 }
+
+Json first(Json j, void *_) {
+    Json key = json_copy(json_list_get(j, 0));
+    json_free(j);
+    return key;
+}
+
+bool below_three(Json j, void *_) {
+    return json_get_number(j) < 3;
+}
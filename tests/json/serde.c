@@ -9,23 +9,27 @@
 #define string(v) v, sizeof(v)
 #define all(v) v, v, sizeof(v)
 
-void test(char *input, char *expected, int str_len) {
+void test_with_flags(char *input, char *expected, int str_len, JsonSerializeFlags flags) {
     printf("Testing %s\n", input);
     DeserializeResult res = json_deserialize(input);
     if (str_len == 0) {
         assert(res.type == RES_ERR);
-        free(res.err.err);
+        jrq_free(res.err.err);
         return;
     }
 
-    char *ser = json_serialize(&res.result, JSON_FLAG_SPACES);
+    char *ser = json_serialize(&res.result, flags);
     json_free(res.result);
     if (strncmp(ser, expected, str_len - 1) != 0) {
         printf("`%s` != `%s`\n", ser, expected);
         assert(ser == expected && "Strings didn't match");
     }
 
-    free(ser);
+    jrq_free(ser);
+}
+
+void test(char *input, char *expected, int str_len) {
+    test_with_flags(input, expected, str_len, JSON_FLAG_SPACES);
 }
 
 void test_simple() {
@@ -75,9 +79,50 @@ void test_list_and_struct() {
     test("   {\"foo\": 10, \"foo\": 2} ", string("{\"foo\": 2}"));
 }
 
+void test_escapes() {
+    test(all("\"a \\\" b \\\\ c \\n\\t\""));
+    test(all("{\"a\\\"b\": [\"\\\\\"]}"));
+    test(
+        "\"\\/ \\u00e9 \\ud83d\\ude00 \\u0001\"",
+        string("\"/ \xc3\xa9 \xf0\x9f\x98\x80 \\u0001\"")
+    );
+    test("\"lone \\udc00\"", string("\"lone \xef\xbf\xbd\""));
+
+    // Long enough to be scanned in bulk, with escapes on both sides of a 16 byte boundary
+    test(
+        all("\"0123456789abcde\\\"0123456789abcdef0123456789abcdef\\n\\u001f0123456789abcdef0123\"")
+    );
+
+    test("\"\\x\"", NULL, 0);
+    test("\"\\u12\"", NULL, 0);
+    test("\"\\\"", NULL, 0);
+}
+
+void test_ascii() {
+    JsonSerializeFlags flags = JSON_FLAG_SPACES | JSON_FLAG_ASCII;
+    test_with_flags(all("\"plain ascii\""), flags);
+    test_with_flags("\"caf\xc3\xa9\"", string("\"caf\\u00e9\""), flags);
+    test_with_flags("\"\\u00e9 \\u20ac\"", string("\"\\u00e9 \\u20ac\""), flags);
+    test_with_flags(
+        "{\"\xf0\x9f\x98\x80\": \"a\\n\"}", string("{\"\\ud83d\\ude00\": \"a\\n\"}"), flags
+    );
+    test_with_flags(
+        "\"0123456789abcdef0123456789\xe2\x82\xac\"",
+        string("\"0123456789abcdef0123456789\\u20ac\""),
+        flags
+    );
+
+    // Invalid utf-8 is replaced one byte at a time
+    test_with_flags("\"a\xff\xc3\"", string("\"a\\ufffd\\ufffd\""), flags);
+}
+
 int main() {
     test_simple();
     printf("\n");
+    test_escapes();
+    printf("\n");
+    test_ascii();
+    printf("\n");
     test_list();
     printf("\n");
     test_struct();
@@ -17,7 +17,7 @@ void test(char *expected, Json input, JsonSerializeFlags flags) {
         assert(false);
     }
 
-    free(res);
+    jrq_free(res);
 }
 
 void test_primitives() {
@@ -113,8 +113,141 @@ void test_objects() {
     );
 }
 
+void test_output_modes() {
+    test("{\"a\":[1,\"b\"]}", JSON_OBJECT("a", JSON_LIST(json_number(1), json_string("b"))), 0);
+
+    test("fo\"o\n", json_string("fo\"o\n"), JSON_FLAG_RAW);
+    test("[\"foo\"]", JSON_LIST(json_string("foo")), JSON_FLAG_RAW);
+
+    test(
+        "1\n{\"a\": [2, 3]}\n\"b\"\n",
+        JSON_LIST(
+            json_number(1),
+            JSON_OBJECT("a", JSON_LIST(json_number(2), json_number(3))),
+            json_string("b")
+        ),
+        JSON_FLAG_NDJSON | JSON_FLAG_SPACES | JSON_FLAG_TAB
+    );
+    test(
+        "b\n[\"c\"]\n",
+        JSON_LIST(json_string("b"), JSON_LIST(json_string("c"))),
+        JSON_FLAG_NDJSON | JSON_FLAG_RAW
+    );
+    test("true\n", json_boolean(true), JSON_FLAG_NDJSON);
+}
+
+void test_serialize_to() {
+    // Big enough to be written out in several parts
+    Json list = json_list();
+    for (int i = 0; i < 50000; i++) {
+        list = json_list_append(list, json_number(i));
+    }
+    char *expected = json_serialize(&list, TAB_FLAGS);
+
+    char *written;
+    size_t length;
+    FILE *out = open_memstream(&written, &length);
+    json_serialize_to(out, &list, TAB_FLAGS);
+    fclose(out);
+
+    assert(length == strlen(expected) && memcmp(written, expected, length) == 0);
+
+    json_free(list);
+    jrq_free(expected);
+    jrq_free(written);
+}
+
+bool string_equals(Json str, char *expected) {
+    Json other = json_string(expected);
+    bool equal = json_equal(str, other);
+    json_free(other);
+    return equal;
+}
+
+void test_small_strings() {
+    test("\"\"", json_string(""), DEFAULT_FLAGS);
+    test("\"a\\tb\\\"\"", json_string("a\tb\""), DEFAULT_FLAGS);
+
+    // Grows past what fits in the header
+    Json str = json_string("0123456789");
+    json_string_concat(str, json_string("abcde"));
+    assert(json_string_length(str) == 15);
+    Json tail = json_string("f");
+    json_string_concat(str, tail);
+    json_free(tail);
+    assert(json_string_length(str) == 16);
+    assert(string_equals(str, "0123456789abcdef"));
+
+    // Both small and borrowed substrings
+    Json small = json_substring(str, 2, 3);
+    Json big = json_substring(str, 0, 16);
+    assert(string_equals(small, "234"));
+    assert(json_equal(big, str));
+    json_free(str);
+    test("\"234\"", small, DEFAULT_FLAGS);
+    test("\"0123456789abcdef\"", big, DEFAULT_FLAGS);
+}
+
+void test_string_equality() {
+    // Strings with NULs in them are compared by all of their bytes
+    Json a = json_string_from(string_from_str_alloc("nul\0a", 5));
+    Json b = json_string_from(string_from_str_alloc("nul\0b", 5));
+    assert(!json_equal(a, b));
+    assert(json_string_hash(a) != json_string_hash(b));
+
+    // Hashes that were computed aren't used anymore once the string changes
+    Json c = json_string_from(string_from_str_alloc("nul\0", 4));
+    json_string_hash(c);
+    Json tail = json_string("a");
+    json_string_concat(c, tail);
+    assert(json_equal(a, c));
+    assert(json_string_hash(a) == json_string_hash(c));
+
+    json_free(a);
+    json_free(b);
+    json_free(c);
+    json_free(tail);
+}
+
+void test_codepoints() {
+    // Long enough that most of it is counted 16 bytes at a time
+    Json mixed = json_string("日本語のテキスト and some ascii text, then 日本語 again");
+    assert(json_string_codepoints(mixed) == 44);
+    assert(json_string_codepoints(mixed) == 44);
+
+    Json slice = json_string_slice(mixed, 8, 13);
+    assert(string_equals(slice, " and "));
+    Json cjk = json_string_slice(mixed, 35, 38);
+    assert(string_equals(cjk, "日本語"));
+    Json tail = json_string_slice(mixed, 38, 100);
+    assert(string_equals(tail, " again"));
+    Json past = json_string_slice(mixed, 50, 60);
+    assert(json_string_length(past) == 0);
+
+    // Slices of ascii strings are ascii as well
+    Json ascii = json_string("only ascii characters in this string");
+    assert(json_string_codepoints(ascii) == 36);
+    Json word = json_string_slice(ascii, 5, 33);
+    assert(json_string_codepoints(word) == 28);
+    json_string_concat(word, cjk);
+    assert(json_string_codepoints(word) == 31);
+
+    json_free(mixed);
+    json_free(slice);
+    json_free(cjk);
+    json_free(tail);
+    json_free(past);
+    json_free(ascii);
+    json_free(word);
+}
+
 int main() {
     test_primitives();
     test_list();
     test_objects();
+    test_output_modes();
+    test_serialize_to();
+    test_small_strings();
+    test_string_equality();
+    test_codepoints();
 }
@@ -4,6 +4,7 @@
 #include "src/parser.h"
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
 
 bool test_eval(char *expr, Json input, Json expected) {
     printf("Testing `%s`\n", expr);
@@ -16,7 +17,7 @@ bool test_eval(char *expr, Json input, Json expected) {
         json_free(expected);
         printf("%s\n", result.err.err);
         fflush(stdout);
-        free(result.err.err);
+        jrq_free(result.err.err);
         return false;
     }
     Json json = result.json;
@@ -29,8 +30,8 @@ bool test_eval(char *expr, Json input, Json expected) {
 
         printf("`%s` does not equal expected `%s`\n", result_str, expected_str);
 
-        free(result_str);
-        free(expected_str);
+        jrq_free(result_str);
+        jrq_free(expected_str);
     }
 
     json_free(input);
@@ -58,6 +59,151 @@ void simple_eval() {
     assert(test_eval("4-6/2 <= (4-6)/2", json_null(), json_boolean(4 - 6 / 2 <= (4 - 6) / 2)));
     assert(test_eval("\"blehh\" == \"blehh\"", json_null(), json_boolean(true)));
     assert(test_eval("\"blehh\" != \"stupid\"", json_null(), json_boolean(true)));
+    assert(test_eval("\"foo\" + \"bar\"", json_null(), json_string("foobar")));
+    assert(test_eval(
+        ".and_then(|v| v + \", \" + v + \" and a string that doesn't fit in the header\")",
+        json_string("input"),
+        json_string("input, input and a string that doesn't fit in the header")
+    ));
+    assert(test_eval(
+        ".split(\" \").map(|w| w + \"!\").join(\" \")",
+        json_string("words that are borrowed from the input"),
+        json_string("words! that! are! borrowed! from! the! input!")
+    ));
+    assert(!test_eval("\"foo\" + 1", json_null(), json_null()));
+    assert(test_eval("\"日本語 text\".length()", json_null(), json_number(8)));
+    assert(test_eval("\"日本語 text\"[1]", json_null(), json_string("本")));
+    assert(test_eval("\"日本語 text\"[8]", json_null(), json_null()));
+    assert(test_eval("\"日本語 text\".substring(2, 6)", json_null(), json_string("語 te")));
+    assert(test_eval(
+        ".unique().collect()",
+        JSON_LIST(json_number(3), json_number(1), json_number(3), json_number(2), json_number(1)),
+        JSON_LIST(json_number(3), json_number(1), json_number(2))
+    ));
+    assert(test_eval(
+        ".unique_by(|v| v.user).map(|v| v.id).collect()",
+        JSON_LIST(
+            JSON_OBJECT("user", json_string("ann"), "id", json_number(1)),
+            JSON_OBJECT("user", json_string("bob"), "id", json_number(2)),
+            JSON_OBJECT("user", json_string("ann"), "id", json_number(3))
+        ),
+        JSON_LIST(json_number(1), json_number(2))
+    ));
+    assert(test_eval(
+        ".group_by(|v| v % 2)",
+        JSON_LIST(json_number(3), json_number(4), json_number(5)),
+        JSON_OBJECT(
+            "1", JSON_LIST(json_number(3), json_number(5)), "0", JSON_LIST(json_number(4))
+        )
+    ));
+    assert(test_eval(
+        ".count_by(|v| v.user)",
+        JSON_LIST(
+            JSON_OBJECT("user", json_string("ann")),
+            JSON_OBJECT("user", json_string("bob")),
+            JSON_OBJECT("user", json_string("ann"))
+        ),
+        JSON_OBJECT("ann", json_number(2), "bob", json_number(1))
+    ));
+    assert(test_eval(
+        ".aggregate(|v| v.user, 0, |acc, v| acc + v.n)",
+        JSON_LIST(
+            JSON_OBJECT("user", json_string("ann"), "n", json_number(1)),
+            JSON_OBJECT("user", json_string("bob"), "n", json_number(2)),
+            JSON_OBJECT("user", json_string("ann"), "n", json_number(3))
+        ),
+        JSON_OBJECT("ann", json_number(4), "bob", json_number(2))
+    ));
+    assert(test_eval(
+        ".sort()",
+        JSON_LIST(json_number(3), json_string("a"), json_null(), json_number(-1), json_string("")),
+        JSON_LIST(json_null(), json_number(-1), json_number(3), json_string(""), json_string("a"))
+    ));
+    assert(test_eval(
+        ".sort_desc()",
+        JSON_LIST(json_string("b"), json_string("ab"), json_string("abc")),
+        JSON_LIST(json_string("b"), json_string("abc"), json_string("ab"))
+    ));
+    assert(test_eval(
+        ".sort_by(|v| v.n).map(|v| v.id).collect()",
+        JSON_LIST(
+            JSON_OBJECT("n", json_number(2), "id", json_number(1)),
+            JSON_OBJECT("n", json_number(1), "id", json_number(2)),
+            JSON_OBJECT("n", json_number(2), "id", json_number(3)),
+            JSON_OBJECT("n", json_number(1), "id", json_number(4))
+        ),
+        JSON_LIST(json_number(2), json_number(4), json_number(1), json_number(3))
+    ));
+    assert(test_eval(
+        ".top_k(2, |v| v.n).map(|v| v.id).collect()",
+        JSON_LIST(
+            JSON_OBJECT("n", json_number(2), "id", json_number(1)),
+            JSON_OBJECT("n", json_number(1), "id", json_number(2)),
+            JSON_OBJECT("n", json_number(3), "id", json_number(3)),
+            JSON_OBJECT("n", json_number(2), "id", json_number(4))
+        ),
+        JSON_LIST(json_number(3), json_number(1))
+    ));
+    assert(test_eval(
+        ".bottom_k(2, |v| 0 - v)",
+        JSON_LIST(json_number(1), json_number(4), json_number(2), json_number(3)),
+        JSON_LIST(json_number(4), json_number(3))
+    ));
+    assert(test_eval(
+        ".sort_desc().take(3).collect()",
+        JSON_LIST(json_number(1), json_number(4), json_number(2), json_number(3)),
+        JSON_LIST(json_number(4), json_number(3), json_number(2))
+    ));
+    assert(test_eval(
+        ".sort_by(|v| v.n).take(1).map(|v| v.id).collect()",
+        JSON_LIST(
+            JSON_OBJECT("n", json_number(2), "id", json_number(1)),
+            JSON_OBJECT("n", json_number(1), "id", json_number(2)),
+            JSON_OBJECT("n", json_number(1), "id", json_number(3))
+        ),
+        JSON_LIST(json_number(2))
+    ));
+    assert(!test_eval(
+        ".sort().take(1)", JSON_OBJECT("b", json_number(2), "a", json_number(1)), json_null()
+    ));
+    Json events = JSON_LIST(
+        JSON_OBJECT("user", json_number(1), "id", json_number(1)),
+        JSON_OBJECT("user", json_number(3), "id", json_number(2)),
+        JSON_OBJECT("user", json_number(1), "id", json_number(3))
+    );
+    Json users = JSON_LIST(
+        JSON_OBJECT("id", json_number(1), "name", json_string("ann")),
+        JSON_OBJECT("id", json_number(2), "name", json_string("bob"))
+    );
+    assert(test_eval(
+        ".events.join_on(.users, |e| e.user, |u| u.id).map(|[e, u]| [e.id, u.name]).collect()",
+        JSON_OBJECT("events", json_copy(events), "users", json_copy(users)),
+        JSON_LIST(
+            JSON_LIST(json_number(1), json_string("ann")),
+            JSON_LIST(json_number(3), json_string("ann"))
+        )
+    ));
+    assert(test_eval(
+        ".events.left_join_on(.users, |e| e.user, |u| u.id).map(|[e, u]| [e.id, u]).collect()",
+        JSON_OBJECT("events", json_copy(events), "users", json_copy(users)),
+        JSON_LIST(
+            JSON_LIST(json_number(1), json_copy(json_list_get(users, 0))),
+            JSON_LIST(json_number(2), json_null()),
+            JSON_LIST(json_number(3), json_copy(json_list_get(users, 0)))
+        )
+    ));
+    // The table is built over the users here, since there are fewer of them
+    assert(test_eval(
+        ".users.left_join_on(.events, |u| u.id, |e| e.user).map(|[u, e]| [u.name, e]).collect()",
+        JSON_OBJECT("events", json_copy(events), "users", json_copy(users)),
+        JSON_LIST(
+            JSON_LIST(json_string("ann"), json_copy(json_list_get(events, 0))),
+            JSON_LIST(json_string("ann"), json_copy(json_list_get(events, 2))),
+            JSON_LIST(json_string("bob"), json_null())
+        )
+    ));
+    json_free(events);
+    json_free(users);
 
     // objects and lists
     assert(test_eval(
@@ -158,10 +304,128 @@ void function_eval() {
         JSON_LIST(JSON_LIST(JSON_LIST(json_number(10), json_string("hji")), json_number(4))),
         json_number(14)
     ));
+    assert(test_eval(
+        ".join(\", \")",
+        JSON_LIST(json_string("a"), json_string("longer string"), json_string("c")),
+        json_string("a, longer string, c")
+    ));
+    assert(test_eval(".join(\",\")", json_list(), json_string("")));
+    assert(test_eval(
+        ".map(|v| v.name).join(\"-\")",
+        JSON_LIST(JSON_OBJECT("name", json_string("x")), JSON_OBJECT("name", json_string("y"))),
+        json_string("x-y")
+    ));
+    assert(!test_eval(".map(|v| v).join(\"-\")", JSON_LIST(json_number(1)), json_null()));
+
+    // Free functions
+    assert(test_eval(
+        "range(0, 1000000000).filter(|v| v % 7 == 3).take(3).collect()",
+        json_null(),
+        JSON_LIST(json_number(3), json_number(10), json_number(17))
+    ));
+    assert(test_eval(
+        "range(10, 0, -4).collect()",
+        json_null(),
+        JSON_LIST(json_number(10), json_number(6), json_number(2))
+    ));
+    assert(test_eval(
+        "range(.n).map(|v| v * v).sum()", JSON_OBJECT("n", json_number(4)), json_number(14)
+    ));
+    assert(test_eval(
+        "range(0, 1000000).filter(|v| v < 3).collect()",
+        json_null(),
+        JSON_LIST(json_number(0), json_number(1), json_number(2))
+    ));
+    assert(!test_eval("range(0, 3, 0)", json_null(), json_null()));
+    assert(!test_eval("range(0, 5, 0).take(3)", json_null(), json_null()));
+    assert(!test_eval(".range(3)", json_null(), json_null()));
+    assert(!test_eval("map(|v| v)", JSON_LIST(json_number(1)), json_null()));
+}
+
+// Evaluates `expr` on both the fully parsed and the projected `input`, and makes sure they agree.
+//
+// `whole` is whether the query should need all of the input.
+bool test_projected_eval(char *expr, char *input, bool whole) {
+    printf("Testing projected `%s`\n", expr);
+    ASTNode *node = ast_parse(expr).node;
+    Projection *projection = eval_projection(node);
+    if (projection->whole != whole) {
+        printf("Expected the projection to%s be whole\n", whole ? "" : " not");
+        return false;
+    }
+
+    DeserializeResult projected = json_deserialize_projected(input, projection);
+    projection_free(projection);
+    ast_free(node);
+    if (projected.type == RES_ERR) {
+        printf("%s\n", projected.err.err);
+        return false;
+    }
+
+    EvalResult result = eval(ast_parse(expr).node, projected.result);
+    json_free(projected.result);
+    if (result.type == RES_ERR) {
+        printf("%s\n", result.err.err);
+        return false;
+    }
+
+    return test_eval(expr, json_deserialize(input).result, result.json);
+}
+
+void projected_eval() {
+    char *input = "{\"items\": [{\"price\": 10, \"tags\": [\"a\", \"b\"], "
+                  "\"skip\": {\"x\": \"]}\"}}, {\"price\": 4, \"tags\": [], \"skip\": [[[]]]}], "
+                  "\"name\": \"foo\", \"n\": [1, 2]}";
+
+    assert(test_projected_eval(".items.map(|v| v.price)", input, false));
+    assert(test_projected_eval(".items.filter(|v| v.price > 5).map(|v| v.tags)", input, false));
+    assert(test_projected_eval(".items.map(|v| {\"p\": v.price}).map(|v| v.p)", input, false));
+    assert(test_projected_eval(".items.enumerate().map(|[i, v]| [i, v.price])", input, false));
+    assert(test_projected_eval(".items.map(|v| 1).collect()", input, false));
+    assert(test_projected_eval(".n.map(|v| .name)", input, false));
+    assert(test_projected_eval(".items.and_then(|v| v[0].price + v[1].price)", input, false));
+    assert(test_projected_eval(".items.take(1).map(|v| v.skip.x)", input, false));
+    assert(test_projected_eval(".name[1]", input, false));
+    assert(test_projected_eval(".items.unique_by(|v| v.price).map(|v| v.tags)", input, false));
+
+    assert(test_projected_eval(".keys()", input, true));
+    assert(test_projected_eval(".items[0].skip.values()", input, false));
+    assert(test_projected_eval("range(2).map(|v| .n[v])", input, false));
+    assert(test_projected_eval("", input, true));
+}
+
+void profiled_eval() {
+    char *code = ".map(|v| v * 2)\n  .filter(|v| v > 2).collect()";
+    printf("Testing `%s`\n", code);
+
+    ASTNode *node = ast_parse(code).node;
+    Profile *profile = profile_new(node);
+    Json input = JSON_LIST(json_number(1), json_number(2), json_number(3));
+    EvalResult result = eval_stream(node, input, NULL, NULL, profile);
+    assert(result.type == RES_OK);
+    Json expected = JSON_LIST(json_number(4), json_number(6));
+    assert(json_equal(result.json, expected));
+
+    char *report = profile_format(profile, code);
+    printf("%s", report);
+
+    // Both lines of the query are shown, and the closure bodies ran once per element
+    char *first = strstr(report, ".map(|v| v * 2)\n");
+    char *second = strstr(report, "  .filter(|v| v > 2).collect()\n");
+    assert(first != NULL && second != NULL && first < second);
+    assert(strstr(report, "         3 ") != NULL);
+
+    jrq_free(report);
+    profile_free(profile);
+    json_free(input);
+    json_free(expected);
+    json_free(result.json);
 }
 
 int main() {
     simple_eval();
     accesor_eval();
     function_eval();
+    projected_eval();
+    profiled_eval();
 }
@@ -93,7 +93,7 @@ void test_simple_lex() {
                     .end = (Position) {.col = 15, .line = 1},
                 },
                 .type = TOKEN_STRING,
-                .inner.ident = string_from_chars("fo\\\"o"),
+                .inner.ident = string_from_chars("fo\"o"),
             },
             (Token) {
                 .range = (Range) {
@@ -22,7 +22,7 @@ static void test_parse(char *input, char *expected_err, ASTNode *exp) {
             printf("'%s' should equal '%s'\n", expected_err, res.err.err);
             assert(false);
         }
-        free(res.err.err);
+        jrq_free(res.err.err);
         return;
     }
 
@@ -35,7 +35,7 @@ static void test_parse(char *input, char *expected_err, ASTNode *exp) {
     ast_free(res.node);
     if (err != NULL) {
         printf("%s\n", err);
-        free(err);
+        jrq_free(err);
         assert(false);
     }
 }
@@ -236,6 +236,21 @@ static void test_access_function_expr() {
         .inner.function.function_name = bar->inner.primary,
     });
 
+    test_parse("bar(foo, 10)", NULL, &(ASTNode) {
+        .type = AST_TYPE_FUNCTION,
+        .range = range_new(1, 1, 1, 12),
+        .inner.function.args = (Vec_ASTNode) {
+            .data = (ASTNode*[]) {
+                foo,
+                ten,
+            },
+            .length = 2,
+        },
+        .inner.function.callee = NULL,
+        .inner.function.function_name = bar->inner.primary,
+        .inner.function.is_free = true,
+    });
+
     test_parse("foo.bar().baz", NULL, &(ASTNode) {
         .type = AST_TYPE_ACCESS,
         .inner.access.accessor = &(ASTNode) {
@@ -438,6 +453,7 @@ static char *validate_ast_node(ASTNode *exp, ASTNode *act) {
         }
         return validate_ast_node(exp->inner.binary.lhs, act->inner.binary.lhs);
     case AST_TYPE_FUNCTION:
+        jqr_assert(INT, exp, act, ->inner.function.is_free);
         err = validate_ast_node(exp->inner.function.callee, act->inner.function.callee);
         if (err != NULL) {
             return err;